@@ -0,0 +1,357 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	Benchmark.cpp
+*****************************************************************************/
+
+#include "Benchmark.h"
+#include "Simulation.h"
+#include "ParticleSystem.h"
+#include "SmoothedGain.h"
+#include "PlaylistSource.h"
+#include <sstream>
+
+namespace
+{
+	using namespace pong;
+	
+	const int32_t kBenchmarkSeed = 1;
+	
+	// the game's grid
+	const int32_t kScreenWidth = 1200;
+	const int32_t kScreenHeight = 800;
+	
+	/*---------------------------------------------------------------------------*/
+	// BenchmarkParticles
+	//   - 10k fragments from 1000 explosions - slow enough that they stay on
+	//     screen for all the iterations
+	void BenchmarkParticles(BenchmarkReport& report)
+	{
+		const int32_t kNumExplosions = 1000;
+		const int64_t kNowMS = 0;
+		Random random(kBenchmarkSeed);
+		
+		std::unique_ptr<ParticleSystem> particles(new ParticleSystem());
+		for (int32_t k = 0; k < kNumExplosions; k++)
+		{
+			const float x = (float)(100 + random.nextInt(kScreenWidth - 200)), y = (float)(100 + random.nextInt(kScreenHeight - 300));
+			for (int32_t j = 0; j < 10; j++)
+			{
+				const float speed = (float)(5 + random.nextInt(25));
+				const float angle = (float)(random.nextDouble() * 2 * M_PI);
+				particles->Add({x, y, speed * std::cos(angle), speed * std::sin(angle), (float)random.nextInt(10), 0, kNowMS + 3600000,
+								random.nextInt(ParticleSystem::kNumColours), (float)(2 + random.nextInt(4))});
+			}
+		}
+		
+		report.Run("particles/animate10000", 600, [&]() { particles->Animate(1.0f / 60, kNowMS, kScreenWidth, kScreenHeight); });
+		
+		Image frame(Image::ARGB, kScreenWidth, kScreenHeight, true);
+		Graphics g(frame);
+		report.Run("particles/draw10000", 100, [&]() { particles->Draw(g); });
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// a looping second of stereo noise - a track that costs next to nothing
+	// to read, so the playlist's own work is what gets timed
+	class NoiseSource : public PositionableAudioSource
+	{
+	public:
+		NoiseSource(double sampleRate) :
+			mNoise(2, (int32_t)sampleRate)
+		{
+			Random random(kBenchmarkSeed);
+			for (int32_t c = 0; c < 2; c++)
+			{
+				float* samples = mNoise.getWritePointer(c);
+				for (int32_t k = 0; k < mNoise.getNumSamples(); k++)
+					samples[k] = (random.nextFloat() * 2) - 1;
+			}
+		}
+		
+		void	prepareToPlay(int, double) override {}
+		void	releaseResources() override {}
+		void	getNextAudioBlock(const AudioSourceChannelInfo& info) override
+		{
+			for (int32_t done = 0; done < info.numSamples;)
+			{
+				const int32_t from = (int32_t)(mPos % mNoise.getNumSamples());
+				const int32_t num = std::min(info.numSamples - done, mNoise.getNumSamples() - from);
+				for (int32_t c = 0; c < std::min(2, info.buffer->getNumChannels()); c++)
+					info.buffer->copyFrom(c, info.startSample + done, mNoise, c, from, num);
+				done += num;
+				mPos += num;
+			}
+		}
+		
+		void	setNextReadPosition(int64 pos) override { mPos = pos; }
+		int64	getNextReadPosition() const override { return mPos; }
+		int64	getTotalLength() const override { return mNoise.getNumSamples(); }
+		bool	isLooping() const override { return true; }
+	
+	private:
+		AudioBuffer<float>	mNoise;
+		int64				mPos = 0;
+	};
+	
+	/*---------------------------------------------------------------------------*/
+	// BenchmarkMusic - the playlist & the gain, the way the audio thread runs them
+	void BenchmarkMusic(BenchmarkReport& report)
+	{
+		// a second of the music at 48k, from tracks at the usual rates (at 48k
+		// it's not resampled) - through the playlist, as the audio thread plays it
+		for (const double sourceRate : {48000.0, 44100.0, 96000.0})
+		{
+			const std::string name = "audio/resample/" + std::to_string((int32_t)sourceRate) + "to48000";
+			if (!report.ShouldRun(name))
+				continue;
+			
+			const double kDeviceRate = 48000;
+			const int32_t kBlockSize = 512;
+			PlaylistSource playlist;
+			playlist.prepareToPlay(kBlockSize, kDeviceRate);
+			playlist.Cue(playlist.NewTrack(0, new NoiseSource(sourceRate), sourceRate, 0, 3600, 1.0f));
+			
+			AudioBuffer<float> buffer(2, kBlockSize);
+			auto playSecond = [&]()
+			{
+				for (int32_t pos = 0; pos < (int32_t)kDeviceRate; pos += kBlockSize)
+					playlist.getNextAudioBlock(AudioSourceChannelInfo(&buffer, 0, std::min(kBlockSize, (int32_t)kDeviceRate - pos)));
+			};
+			playSecond();
+			
+			const int64_t seconds = report.Iterations(20);
+			const int64_t start = Time::getHighResolutionTicks();
+			for (int64_t k = 0; k < seconds; k++)
+				playSecond();
+			
+			const double totalMS = TicksToMS(Time::getHighResolutionTicks() - start);
+			report.Add(name, seconds, totalMS, {{"cpu_pct", totalMS / seconds / 10.0}});
+			playlist.Update(nullptr);
+		}
+		
+		// the music's audio callback at the usual block sizes - the playlist
+		// filling the block (a copy here), then the gain: the old scalar loop,
+		// unity (skipped), a steady gain, and a new target every block
+		for (const int32_t blockSize : {64, 128, 256, 512, 1024, 2048})
+		{
+			const int32_t kNumChannels = 2;
+			AudioBuffer<float> source(kNumChannels, blockSize);
+			AudioBuffer<float> buffer(kNumChannels, blockSize);
+			Random random(kBenchmarkSeed);
+			for (int32_t c = 0; c < kNumChannels; c++)
+			{
+				float* samples = source.getWritePointer(c);
+				for (int32_t k = 0; k < blockSize; k++)
+					samples[k] = (random.nextFloat() * 2) - 1;
+			}
+			
+			auto fill = [&]()
+			{
+				for (int32_t c = 0; c < kNumChannels; c++)
+					buffer.copyFrom(c, 0, source, c, 0, blockSize);
+			};
+			
+			// the same number of samples at every block size
+			const std::string size = std::to_string(blockSize);
+			const int64_t iterations = (1 << 22) / blockSize;
+			
+			const double scalarGain = 0.7;
+			report.Run("audio/gain/scalar/" + size, iterations, [&]()
+			{
+				fill();
+				for (int32_t c = 0; c < kNumChannels; c++)
+				{
+					float* samples = buffer.getWritePointer(c);
+					for (int32_t k = 0; k < blockSize; k++)
+						samples[k] *= scalarGain;
+				}
+			});
+			
+			SmoothedGain unity;
+			report.Run("audio/gain/unity/" + size, iterations, [&]() { fill(); unity.Process(buffer, 0, blockSize); });
+			
+			SmoothedGain steady;
+			steady.SetTarget(0.7f);
+			report.Run("audio/gain/steady/" + size, iterations, [&]() { fill(); steady.Process(buffer, 0, blockSize); });
+			
+			SmoothedGain ramp;
+			report.Run("audio/gain/ramp/" + size, iterations, [&]()
+			{
+				ramp.SetTarget((ramp.GetCurrent() == 1.0f) ? 0.5f : 1.0f);
+				fill();
+				ramp.Process(buffer, 0, blockSize);
+			});
+		}
+	}
+}
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+void BenchmarkReport::Add(const std::string& name, int64_t iterations, double totalMS,
+						  std::vector<std::pair<std::string, double>> extra)
+{
+	mResults.push_back({name, iterations, totalMS, extra});
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	ToJSON
+//   - one object per benchmark, ns_per_op is the value to compare across runs
+/*---------------------------------------------------------------------------*/
+std::string BenchmarkReport::ToJSON() const
+{
+	std::stringstream os;
+	os << "{\n";
+	os << "  \"version\": 1,\n";
+	os << "  \"cpu\": \"" << SystemStats::getCpuModel().toStdString() << "\",\n";
+	os << "  \"numCores\": " << SystemStats::getNumCpus() << ",\n";
+	os << "  \"benchmarks\": [\n";
+	
+	for (size_t k = 0; k < mResults.size(); k++)
+	{
+		const Result& r = mResults[k];
+		os << "    {\"name\": \"" << r.mName << "\"";
+		os << ", \"iterations\": " << r.mIterations;
+		os << ", \"total_ms\": " << r.mTotalMS;
+		os << ", \"ns_per_op\": " << r.NanosPerOp();
+		for (auto& extra : r.mExtra)
+			os << ", \"" << extra.first << "\": " << extra.second;
+		os << "}" << (k + 1 < mResults.size() ? "," : "") << "\n";
+	}
+	
+	os << "  ]\n";
+	os << "}\n";
+	return os.str();
+}
+
+/*---------------------------------------------------------------------------*/
+void BenchmarkReport::Print() const
+{
+	for (const Result& r : mResults)
+	{
+		printf("%-24s %10lld iters  %14.1f ns/op", r.mName.c_str(), (long long)r.mIterations, r.NanosPerOp());
+		for (auto& extra : r.mExtra)
+			printf("  %s: %.2f", extra.first.c_str(), extra.second);
+		printf("\n");
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	CompareWithBaseline
+//   - print the change in ns/op for every benchmark that's in both runs
+/*---------------------------------------------------------------------------*/
+void BenchmarkReport::CompareWithBaseline(const String& json) const
+{
+	const var baseline = JSON::parse(json);
+	const Array<var>* list = baseline["benchmarks"].getArray();
+	if (!list)
+	{
+		printf("baseline: no benchmarks found\n");
+		return;
+	}
+	
+	printf("\nvs baseline (ns/op, negative is faster):\n");
+	for (const Result& r : mResults)
+	{
+		for (const var& b : *list)
+		{
+			if (b["name"].toString().toStdString() != r.mName)
+				continue;
+			
+			const double before = b["ns_per_op"];
+			if (before > 0)
+				printf("%-24s %14.1f -> %14.1f  %+7.1f%%\n", r.mName.c_str(), before, r.NanosPerOp(),
+					   100.0 * (r.NanosPerOp() - before) / before);
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RunMicroBenchmarks
+/*---------------------------------------------------------------------------*/
+void RunMicroBenchmarks(BenchmarkReport& report)
+{
+	RunGameBenchmarks(report);
+	BenchmarkParticles(report);
+	BenchmarkMusic(report);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RunMacroBenchmarks
+//   - the same canned input in every game mode - one op is one frame
+/*---------------------------------------------------------------------------*/
+void RunMacroBenchmarks(BenchmarkReport& report)
+{
+	for (const GameMode mode : {eStartScreen, eAsteroids, eDistanceGame, eHostageRescue, eGravityShepherd})
+	{
+		const std::string name = std::string("macro/") + GameModeName(mode);
+		if (!report.ShouldRun(name))
+			continue;
+		
+		SimulationOptions options;
+		options.mNumTicks = report.Iterations(2000);
+		options.mMode = mode;
+		options.mScript = eScriptMixed;
+		
+		const SimulationResult r = RunSimulation(options);
+		report.Add(name, r.mNumTicks, r.mElapsedMS,
+				   {{"ticks_per_sec", r.TicksPerSec()},
+					{"frame_avg_ms", r.mFrameMS / r.mNumTicks},
+					{"frame_max_ms", r.mMaxFrameMS},
+					{"objects_avg", (double)r.mTotalObjects / r.mNumTicks},
+					{"objects_max", (double)r.mMaxObjects},
+					{"pool_high_water", (double)r.mPool.GetTotalStats().mHighWater},
+					{"pool_failed", (double)r.mPool.GetTotalStats().mNumFailed}});
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RunBenchmarks
+/*---------------------------------------------------------------------------*/
+int32_t RunBenchmarks(const StringArray& args)
+{
+	const String filter = ArgValue(args, "--filter", "");
+	const String outPath = ArgValue(args, "--out", "");
+	const String baselinePath = ArgValue(args, "--baseline", "");
+	
+	BenchmarkReport report(filter, args.contains("--quick") ? 0.1 : 1.0);
+	RunMicroBenchmarks(report);
+	RunMacroBenchmarks(report);
+	
+	report.Print();
+	
+	const std::string json = report.ToJSON();
+	if (outPath.isNotEmpty())
+	{
+		if (!File(outPath).replaceWithText(json))
+		{
+			printf("bench: couldn't write %s\n", outPath.toRawUTF8());
+			return 1;
+		}
+	}
+	else
+	{
+		printf("\n%s", json.c_str());
+	}
+	
+	if (baselinePath.isNotEmpty())
+	{
+		const File baseline(baselinePath);
+		if (!baseline.existsAsFile())
+		{
+			printf("bench: no baseline at %s\n", baselinePath.toRawUTF8());
+			return 1;
+		}
+		report.CompareWithBaseline(baseline.loadFileAsString());
+	}
+	
+	for (const std::string& failure : report.GetFailures())
+		printf("bench: FAILED %s\n", failure.c_str());
+	
+	return report.GetFailures().empty() ? 0 : 1;
+}
+
+} // pong namespace
@@ -0,0 +1,95 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	Benchmark.h
+	
+	Micro & macro benchmarks. The micro benchmarks time the hot paths of the
+	game (CObjectPool, CObject, drawing) and its helpers on repeatable
+	fixtures, one fixture function per subsystem; the macro benchmarks replay
+	canned input through a headless game in each GameMode. Results are
+	written as JSON, and can be compared against a previous run.
+	
+	usage: SpaceForce --bench [--filter substring] [--quick]
+	                          [--out results.json] [--baseline results.json]
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Profiler.h"
+#include <string>
+#include <vector>
+
+namespace pong
+{
+
+// BenchmarkReport - runs the benchmarks that pass the filter and collects the results
+class BenchmarkReport
+{
+public:
+	struct Result
+	{
+		std::string	mName;
+		int64_t		mIterations;
+		double		mTotalMS;
+		
+		// additional named values, e.g. ticks/sec for the macro benchmarks
+		std::vector<std::pair<std::string, double>> mExtra;
+		
+		double NanosPerOp() const { return mIterations ? (mTotalMS * 1000000.0 / mIterations) : 0.0; }
+	};
+	
+	BenchmarkReport(const String& filter, double scale) :
+		mFilter(filter),
+		mScale(scale)
+	{}
+	
+	bool ShouldRun(const std::string& name) const { return mFilter.isEmpty() || String(name).contains(mFilter); }
+	
+	// scale the iteration count (--quick runs a tenth of the iterations)
+	int64_t Iterations(int64_t iterations) const { return std::max((int64_t)1, (int64_t)(iterations * mScale)); }
+	
+	// Run - time func() over the (scaled) number of iterations, after one warm-up call
+	template <typename F>
+	void Run(const std::string& name, int64_t iterations, F func)
+	{
+		if (!this->ShouldRun(name))
+			return;
+		
+		iterations = this->Iterations(iterations);
+		func();
+		
+		const int64_t start = Time::getHighResolutionTicks();
+		for (int64_t k = 0; k < iterations; k++)
+			func();
+		
+		this->Add(name, iterations, TicksToMS(Time::getHighResolutionTicks() - start));
+	}
+	
+	void		Add(const std::string& name, int64_t iterations, double totalMS,
+					std::vector<std::pair<std::string, double>> extra = {});
+	
+	// a benchmark whose output came out wrong - the run still finishes, but
+	// RunBenchmarks prints these & returns non-zero
+	void		Fail(const std::string& message) { mFailures.push_back(message); }
+	const std::vector<std::string>& GetFailures() const { return mFailures; }
+
+	std::string	ToJSON() const;
+	void		Print() const;
+	void		CompareWithBaseline(const String& json) const;
+	
+private:
+	const String		mFilter;
+	const double		mScale;
+	std::vector<Result>	mResults;
+	std::vector<std::string> mFailures;
+};
+
+// the fixtures that need CObject & CObjectPool live in SpaceForce.cpp - the
+// ones that only use a public API (particles, music) are in Benchmark.cpp
+void RunGameBenchmarks(BenchmarkReport& report);
+
+// returns the process exit code
+int32_t RunBenchmarks(const StringArray& args);
+
+} // pong namespace
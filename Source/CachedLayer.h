@@ -0,0 +1,126 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	CachedLayer.h
+	
+	A part of the screen that rarely changes - the logo & minimap outline,
+	the control strip, the intro window, the score stats - rendered into
+	its own transparent image and composited into each frame with a single
+	blit. A layer is only re-rendered when its key, a hash of whatever its
+	content depends on, changes.
+	
+	When the game is drawn scaled, the layer's image is at the device
+	resolution (so its text & lines stay sharp) and is still composited
+	with a plain blit.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <string>
+
+namespace pong
+{
+
+// LayerKey - FNV-1a over the values a layer's content depends on
+class LayerKey
+{
+public:
+	LayerKey& Add(int64_t value)
+	{
+		for (int32_t k = 0; k < 8; k++)
+			this->AddByte((uint8_t)(value >> (k * 8)));
+		return *this;
+	}
+	
+	LayerKey& Add(const std::string& s)
+	{
+		for (const char c : s)
+			this->AddByte((uint8_t)c);
+		return this->Add((int64_t)s.size());
+	}
+	
+	uint64_t Get() const { return mHash; }
+
+private:
+	void AddByte(uint8_t b) { mHash = (mHash ^ b) * 1099511628211ull; }
+	
+	uint64_t mHash = 14695981039346656037ull;
+};
+
+// CachedLayer
+class CachedLayer
+{
+public:
+	// the layer covers bounds (in screen coordinates) - changing them re-renders it
+	void SetBounds(const Rectangle<int>& bounds)
+	{
+		mBounds = bounds;
+		mImage = Image();
+		mValid = false;
+	}
+	
+	const Rectangle<int>& GetBounds() const { return mBounds; }
+	void Invalidate() { mValid = false; }
+	
+	// the render scale g will have - changing it re-renders the layer
+	void SetScale(float scale)
+	{
+		if (scale == mScale)
+			return;
+		
+		mScale = scale;
+		mImage = Image();
+		mValid = false;
+	}
+	
+	// Draw - composites the layer into g, first calling render() to redraw it
+	// if key isn't the one it was last rendered with. render() draws in screen
+	// coordinates, starting with g's font. Returns true if it re-rendered.
+	template <typename F>
+	bool Draw(Graphics& g, uint64_t key, F render)
+	{
+		// where the layer lands in device pixels
+		const Rectangle<int> device = (mBounds.toFloat() * mScale).getSmallestIntegerContainer();
+		
+		const bool stale = (!mValid || key != mKey);
+		if (stale)
+		{
+			if (mImage.isValid())
+				mImage.clear(mImage.getBounds());
+			else
+				mImage = Image(Image::ARGB, device.getWidth(), device.getHeight(), true);
+			
+			Graphics lg(mImage);
+			lg.setOrigin(-device.getX(), -device.getY());
+			if (mScale != 1.0f)
+				lg.addTransform(AffineTransform::scale(mScale));
+			lg.setFont(g.getCurrentFont());
+			render(lg);
+			
+			mKey = key;
+			mValid = true;
+		}
+		
+		if (mScale == 1.0f)
+		{
+			g.drawImageAt(mImage, mBounds.getX(), mBounds.getY());
+		}
+		else
+		{
+			Graphics::ScopedSaveState state(g);
+			g.addTransform(AffineTransform::scale(1.0f / mScale));
+			g.drawImageAt(mImage, device.getX(), device.getY());
+		}
+		return stale;
+	}
+
+private:
+	Rectangle<int>	mBounds;
+	Image			mImage;
+	uint64_t		mKey = 0;
+	bool			mValid = false;
+	float			mScale = 1.0f;
+};
+
+} // pong namespace
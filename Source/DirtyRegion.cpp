@@ -0,0 +1,137 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	DirtyRegion.cpp
+*****************************************************************************/
+
+#include "DirtyRegion.h"
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+void DirtyRegion::SetBounds(int32_t width, int32_t height)
+{
+	mWidth = width;
+	mHeight = height;
+	mNumCols = (width + kTileSize - 1) / kTileSize;
+	mNumRows = (height + kTileSize - 1) / kTileSize;
+	mTiles.assign((size_t)(mNumCols * mNumRows), 0);
+	mText.clear();
+	mLastText.clear();
+	mAll = true;
+}
+
+/*---------------------------------------------------------------------------*/
+void DirtyRegion::Add(const Rectangle<int>& r)
+{
+	if (!mAll)
+		this->MarkTiles(r);
+}
+
+/*---------------------------------------------------------------------------*/
+void DirtyRegion::MarkTiles(const Rectangle<int>& r)
+{
+	const Rectangle<int> clipped = r.getIntersection({0, 0, mWidth, mHeight});
+	if (clipped.isEmpty())
+		return;
+	
+	const int32_t col0 = clipped.getX() / kTileSize;
+	const int32_t col1 = (clipped.getRight() - 1) / kTileSize;
+	const int32_t row0 = clipped.getY() / kTileSize;
+	const int32_t row1 = (clipped.getBottom() - 1) / kTileSize;
+	
+	for (int32_t row = row0; row <= row1; row++)
+	{
+		uint8_t* tiles = &mTiles[(size_t)(row * mNumCols)];
+		for (int32_t col = col0; col <= col1; col++)
+			tiles[col] = 1;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void DirtyRegion::AddText(const Rectangle<int>& r, const std::string& text)
+{
+	mText.push_back({r, text});
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	TakeRectangles
+//   - each row's runs of dirty tiles, merged with the rows above by RectangleList
+/*---------------------------------------------------------------------------*/
+const RectangleList<int>& DirtyRegion::TakeRectangles()
+{
+	mRectangles.clear();
+	
+	if (mAll)
+	{
+		mRectangles.add({0, 0, mWidth, mHeight});
+		mCoverage = 1.0;
+		mAll = false;
+		return mRectangles;
+	}
+	
+	int64_t area = 0;
+	for (int32_t row = 0; row < mNumRows; row++)
+	{
+		const uint8_t* tiles = &mTiles[(size_t)(row * mNumCols)];
+		for (int32_t col = 0; col < mNumCols; )
+		{
+			if (!tiles[col])
+			{
+				col++;
+				continue;
+			}
+			
+			const int32_t start = col;
+			while (col < mNumCols && tiles[col])
+				col++;
+			
+			const Rectangle<int> run = Rectangle<int>(start * kTileSize, row * kTileSize, (col - start) * kTileSize, kTileSize)
+											.getIntersection({0, 0, mWidth, mHeight});
+			area += ((int64_t)run.getWidth() * run.getHeight());
+			mRectangles.add(run);
+		}
+	}
+	
+	std::fill(mTiles.begin(), mTiles.end(), 0);
+	
+	mCoverage = (mWidth && mHeight) ? ((double)area / ((int64_t)mWidth * mHeight)) : 0.0;
+	return mRectangles;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	AddTextChanges
+//   - new, changed & vanished strings all dirty their rect
+/*---------------------------------------------------------------------------*/
+void DirtyRegion::AddTextChanges()
+{
+	auto find = [](const std::vector<TextEntry>& list, const Rectangle<int>& r) -> const TextEntry*
+	{
+		for (const TextEntry& e : list)
+		{
+			if (e.mRect == r)
+				return &e;
+		}
+		return nullptr;
+	};
+	
+	for (const TextEntry& e : mText)
+	{
+		const TextEntry* last = find(mLastText, e.mRect);
+		if (!last || last->mText != e.mText)
+			this->Add(e.mRect);
+	}
+	
+	for (const TextEntry& e : mLastText)
+	{
+		if (!find(mText, e.mRect))
+			this->Add(e.mRect);
+	}
+	
+	mLastText.swap(mText);
+	mText.clear();
+}
+
+} // pong namespace
@@ -0,0 +1,84 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	DirtyRegion.h
+	
+	The parts of the screen that changed since the last frame. Most of a
+	Distance Game frame is black sky that looks the same as last time, so
+	TPongView clips each frame to this region and only clears & redraws
+	what's in it - the rest of the frame is left over from last time.
+	
+	Changes are marked on a grid of kTileSize tiles, so any number of small
+	rects (old & new object bounds) costs the same, and comes back out as a
+	handful of merged rectangles for the clip & for repaint().
+	
+	HUD text can't know it changed until it's drawn, so TPongView records
+	the HUD before taking the clip - each string is compared with the one
+	drawn in the same rect last frame, and a change dirties it this frame.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <string>
+#include <vector>
+
+namespace pong
+{
+
+// DirtyRegion
+class DirtyRegion
+{
+public:
+	static const int32_t kTileSize = 32;
+	
+	DirtyRegion() { this->SetBounds(0, 0); }
+	
+	// sizes the grid & dirties all of it
+	void	SetBounds(int32_t width, int32_t height);
+	
+	// this frame
+	void	Add(const Rectangle<int>& r);
+	void	AddAll() { mAll = true; }
+	bool	IsAll() const { return mAll; }
+	
+	// text drawn this frame - a string that differs from the one drawn in the
+	// same rect last frame (or that's no longer drawn) dirties it
+	void	AddText(const Rectangle<int>& r, const std::string& text);
+	
+	// compares this frame's text with the last - once all of it has been
+	// added, before TakeRectangles
+	void	AddTextChanges();
+	
+	// the merged rectangles to clear & redraw this frame - anything added
+	// after this (objects freed later in the frame) goes into the next one
+	const RectangleList<int>& TakeRectangles();
+	const RectangleList<int>& GetRectangles() const { return mRectangles; }
+	
+	// fraction of the screen in the last TakeRectangles()
+	double	GetCoverage() const { return mCoverage; }
+
+private:
+	struct TextEntry
+	{
+		Rectangle<int>	mRect;
+		std::string		mText;
+	};
+	
+	void	MarkTiles(const Rectangle<int>& r);
+	
+	int32_t		mWidth;
+	int32_t		mHeight;
+	int32_t		mNumCols;
+	int32_t		mNumRows;
+	bool		mAll;
+	std::vector<uint8_t> mTiles; // row major, 1 = dirty
+	
+	RectangleList<int>	mRectangles;
+	double		mCoverage = 1.0;
+	
+	std::vector<TextEntry> mText;
+	std::vector<TextEntry> mLastText;
+};
+
+} // pong namespace
@@ -0,0 +1,202 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	FlightRecorder.cpp
+*****************************************************************************/
+
+#include "FlightRecorder.h"
+
+namespace pong
+{
+
+namespace
+{
+	const char kFlightMagic[4] = {'S', 'F', 'F', 'R'};
+	const uint32_t kFlightVersion = 1;
+}
+
+/*---------------------------------------------------------------------------*/
+// FreezeWriter - writes frozen rings out, off the game thread
+class FlightRecorder::FreezeWriter : public Thread
+{
+public:
+	FreezeWriter(FlightRecorder& recorder) : Thread("FlightRecorder"), mRecorder(recorder) {}
+	
+	virtual void run() override
+	{
+		gTraceRecorder.SetThreadName("flightRecorder");
+		
+		while (!this->threadShouldExit())
+		{
+			this->wait(250);
+			this->WritePending();
+		}
+		
+		this->WritePending();
+	}
+
+private:
+	void WritePending()
+	{
+		if (!mRecorder.mFreezePending.load(std::memory_order_acquire))
+			return;
+		
+		StTraceScope trace("writeHitch");
+		const File file = mRecorder.mFolder.getChildFile("Hitch-" + Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".ring")
+															.getNonexistentSibling();
+		if (file.replaceWithData(mRecorder.mFreezeBuffer.get(), mRecorder.mFreezeSize))
+			printf("flight recorder: hitch written to %s\n", file.getFullPathName().toRawUTF8());
+		
+		mRecorder.mFreezePending.store(false, std::memory_order_release);
+	}
+	
+	FlightRecorder& mRecorder;
+};
+
+/*---------------------------------------------------------------------------*/
+FlightRecorder::FlightRecorder() :
+	mHeader(nullptr),
+	mRecords(nullptr),
+	mFreezeAtFrame(0),
+	mFreezeSize(0),
+	mFreezePending(false)
+{
+}
+
+/*---------------------------------------------------------------------------*/
+FlightRecorder::~FlightRecorder()
+{
+	if (mWriter)
+		mWriter->stopThread(2000);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Open
+/*---------------------------------------------------------------------------*/
+bool FlightRecorder::Open(const File& folder, double hitchMS)
+{
+	mFolder = folder;
+	mFolder.createDirectory();
+	
+	// the last run's ring is what we'd want after a crash - don't write over it
+	const File ring = mFolder.getChildFile("FlightRecorder.ring");
+	if (ring.existsAsFile())
+	{
+		const File previous = mFolder.getChildFile("FlightRecorder-previous.ring");
+		previous.deleteFile();
+		ring.moveFileTo(previous);
+	}
+	
+	const size_t size = sizeof(FlightHeader) + (kNumRecords * sizeof(FlightRecord));
+	{
+		FileOutputStream out(ring);
+		if (out.failedToOpen())
+			return false;
+		out.writeRepeatedByte(0, size);
+	}
+	
+	mMappedFile.reset(new MemoryMappedFile(ring, MemoryMappedFile::readWrite));
+	if (!mMappedFile->getData() || mMappedFile->getSize() < size)
+	{
+		mMappedFile.reset();
+		return false;
+	}
+	
+	// touch every page now, so Record() never faults one in
+	memset(mMappedFile->getData(), 0, size);
+	
+	mHeader = static_cast<FlightHeader*>(mMappedFile->getData());
+	memcpy(mHeader->mMagic, kFlightMagic, sizeof(kFlightMagic));
+	mHeader->mVersion = kFlightVersion;
+	mHeader->mRecordSize = sizeof(FlightRecord);
+	mHeader->mNumRecords = kNumRecords;
+	mHeader->mNumWritten = 0;
+	mHeader->mHitchMS = (float)hitchMS;
+	mRecords = reinterpret_cast<FlightRecord*>(mHeader + 1);
+	
+	mFreezeSize = size;
+	mFreezeBuffer.malloc(size);
+	mWriter.reset(new FreezeWriter(*this));
+	mWriter->startThread();
+	
+	printf("flight recorder: %s (hitch > %.0f ms)\n", ring.getFullPathName().toRawUTF8(), hitchMS);
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Record
+/*---------------------------------------------------------------------------*/
+void FlightRecorder::Record(const FlightRecord& record)
+{
+	if (!this->IsOpen())
+		return;
+	
+	// the record lands before the count that publishes it
+	const uint64_t n = mHeader->mNumWritten;
+	mRecords[n % kNumRecords] = record;
+	std::atomic_thread_fence(std::memory_order_release);
+	mHeader->mNumWritten = (n + 1);
+	
+	// one freeze at a time - hitches while one is pending end up in it anyway
+	if (!mFreezeAtFrame && record.mFrameMS > mHeader->mHitchMS && !mFreezePending.load(std::memory_order_acquire))
+		mFreezeAtFrame = (n + kFramesAfterHitch);
+	
+	if (mFreezeAtFrame && n >= mFreezeAtFrame)
+	{
+		this->Freeze();
+		mFreezeAtFrame = 0;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void FlightRecorder::Freeze()
+{
+	memcpy(mFreezeBuffer.get(), mHeader, mFreezeSize);
+	mFreezePending.store(true, std::memory_order_release);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DumpCSV
+/*---------------------------------------------------------------------------*/
+bool FlightRecorder::DumpCSV(const File& in, OutputStream& out)
+{
+	MemoryBlock data;
+	if (!in.loadFileAsData(data) || data.getSize() < sizeof(FlightHeader))
+		return false;
+	
+	const FlightHeader& header = *static_cast<const FlightHeader*>(data.getData());
+	if (memcmp(header.mMagic, kFlightMagic, sizeof(kFlightMagic)) != 0 ||
+		header.mVersion != kFlightVersion ||
+		header.mRecordSize != sizeof(FlightRecord) ||
+		data.getSize() < sizeof(FlightHeader) + ((size_t)header.mNumRecords * sizeof(FlightRecord)))
+		return false;
+	
+	const FlightRecord* records = reinterpret_cast<const FlightRecord*>(&header + 1);
+	
+	out << "frame,now_ms,interval_ms,frame_ms";
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+		out << "," << PhaseName((ProfilePhase)k) << "_ms";
+	for (int32_t t = 0; t < kNumObjectTypes; t++)
+		out << "," << ObjectTypeName(t);
+	out << ",inputs,game_mode,distance_game_status\n";
+	
+	// oldest first
+	const uint64_t end = header.mNumWritten;
+	const uint64_t begin = (end > header.mNumRecords ? end - header.mNumRecords : 0);
+	for (uint64_t n = begin; n < end; n++)
+	{
+		const FlightRecord& r = records[n % header.mNumRecords];
+		out << String((int64)r.mFrame) << "," << String((int64)r.mNowMS) << ","
+			<< String(r.mIntervalMS, 3) << "," << String(r.mFrameMS, 3);
+		for (int32_t k = 0; k < eNumProfilePhases; k++)
+			out << "," << String(r.mPhaseMS[k], 3);
+		for (int32_t t = 0; t < kNumObjectTypes; t++)
+			out << "," << (int)r.mObjects[t];
+		out << "," << (int)r.mInputs << "," << (int)r.mGameMode << "," << (int)r.mDistanceGameStatus << "\n";
+	}
+	
+	return true;
+}
+
+} // pong namespace
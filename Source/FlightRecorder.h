@@ -0,0 +1,105 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	FlightRecorder.h
+	
+	Hitch flight recorder. Every frame appends one fixed size FlightRecord to
+	a ring in a memory mapped file, so recording is a copy into mapped memory
+	(no syscalls) and whatever made it into the ring survives a crash - the
+	next launch moves the old ring aside as FlightRecorder-previous.ring.
+	
+	When a frame goes over the hitch threshold, the ring is frozen (a little
+	after the hitch, so the aftermath is in there too) and a background thread
+	writes it to its own Hitch-<time>.ring file.
+	
+	Files live in the SpaceForce folder in the user's application data.
+	read one with: SpaceForce --dump-flight file.ring [--out frames.csv]
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Profiler.h"
+#include "PoolTelemetry.h"
+#include <atomic>
+#include <memory>
+
+namespace pong
+{
+
+// FlightInput - the keys held down during a frame
+enum FlightInput
+{
+	eInputThrust	= 1 << 0,
+	eInputLeft		= 1 << 1,
+	eInputRight		= 1 << 2,
+	eInputShoot		= 1 << 3,
+	eInputBomb		= 1 << 4
+};
+
+// FlightRecord - one frame (plain old data, written straight into the file)
+struct FlightRecord
+{
+	uint64_t	mFrame;
+	int64_t		mNowMS;
+	float		mIntervalMS;	// since the previous frame started
+	float		mFrameMS;
+	float		mPhaseMS[eNumProfilePhases];
+	uint16_t	mObjects[kNumObjectTypes];	// in use, by ObjectTypeIndex (eFragment counts the particles)
+	uint16_t	mInputs;		// FlightInput bits
+	int8_t		mGameMode;
+	int8_t		mDistanceGameStatus;
+};
+
+// FlightHeader - at the start of every ring file
+struct FlightHeader
+{
+	char		mMagic[4];		// "SFFR"
+	uint32_t	mVersion;
+	uint32_t	mRecordSize;
+	uint32_t	mNumRecords;
+	uint64_t	mNumWritten;	// total frames recorded - the next one goes in slot (mNumWritten % mNumRecords)
+	float		mHitchMS;
+	uint32_t	mReserved[9];
+};
+
+// FlightRecorder
+class FlightRecorder
+{
+public:
+	static const uint32_t kNumRecords = 1024;		// ~30 sec at the game's frame rate
+	static const uint32_t kFramesAfterHitch = 30;	// keep recording this long before freezing
+	
+	FlightRecorder();
+	~FlightRecorder();
+	
+	// maps (and moves any previous ring aside) - false if the file can't be mapped
+	bool	Open(const File& folder, double hitchMS);
+	bool	IsOpen() const { return (mHeader != nullptr); }
+	
+	// the hot path - no allocation, no syscalls
+	void	Record(const FlightRecord& record);
+	
+	// writes the records in the file at 'in' (oldest first) as CSV to 'out'
+	static bool DumpCSV(const File& in, OutputStream& out);
+
+private:
+	class FreezeWriter;
+	
+	void	Freeze();
+	
+	std::unique_ptr<MemoryMappedFile> mMappedFile;
+	FlightHeader*	mHeader;
+	FlightRecord*	mRecords;
+	File			mFolder;
+	
+	uint64_t		mFreezeAtFrame; // 0 when no hitch is pending
+	
+	// the frozen copy, handed to the writer thread
+	HeapBlock<char>	mFreezeBuffer;
+	size_t			mFreezeSize;
+	std::atomic<bool> mFreezePending;
+	std::unique_ptr<FreezeWriter> mWriter;
+};
+
+} // pong namespace
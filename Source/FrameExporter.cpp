@@ -0,0 +1,152 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	FrameExporter.cpp
+*****************************************************************************/
+
+#include "FrameExporter.h"
+#include "Trace.h"
+#include <algorithm>
+#include <string.h>
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+FrameExporter::FrameExporter(const File& dir, int32_t numThreads) :
+	mDir(dir),
+	mNumThreads(std::max(1, numThreads)),
+	mNumPending(0),
+	mNumWritten(0),
+	mNumFailed(0),
+	mEncodeTicks(0),
+	mFirstAddTicks(0),
+	mLastWrittenTicks(0),
+	mPool(mNumThreads)
+{
+	mDir.createDirectory();
+}
+
+/*---------------------------------------------------------------------------*/
+FrameExporter::~FrameExporter()
+{
+	this->Finish();
+}
+
+/*---------------------------------------------------------------------------*/
+void FrameExporter::Add(const Image& frame, int64_t n)
+{
+	StTraceScope trace("exportFrame");
+	if (mFirstAddTicks == 0)
+		mFirstAddTicks = Time::getHighResolutionTicks();
+	
+	if (mNumPending >= kMaxPending)
+	{
+		const int64_t start = Time::getHighResolutionTicks();
+		while (mNumPending >= kMaxPending)
+			mFrameWritten.wait(10);
+		mStallTicks += (Time::getHighResolutionTicks() - start);
+	}
+	
+	const Image image = this->Acquire(frame);
+	const File file = mDir.getChildFile(String::formatted("frame_%06lld.png", (long long)n));
+	
+	mNumPending++;
+	mPool.addJob([this, image, file]() { this->Write(image, file); });
+}
+
+/*---------------------------------------------------------------------------*/
+void FrameExporter::Finish()
+{
+	while (mNumPending > 0)
+		mFrameWritten.wait(10);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Acquire
+//   - a copy of frame, in a spare image if there's one the right size
+/*---------------------------------------------------------------------------*/
+Image FrameExporter::Acquire(const Image& frame)
+{
+	Image image;
+	{
+		const ScopedLock lock(mLock);
+		while (!mSpareImages.empty() && !image.isValid())
+		{
+			if (mSpareImages.back().getBounds() == frame.getBounds() && mSpareImages.back().getFormat() == frame.getFormat())
+				image = mSpareImages.back();
+			mSpareImages.pop_back();
+		}
+	}
+	
+	if (!image.isValid())
+		image = Image(frame.getFormat(), frame.getWidth(), frame.getHeight(), false);
+	
+	const Image::BitmapData src(frame, Image::BitmapData::readOnly);
+	const Image::BitmapData dst(image, Image::BitmapData::writeOnly);
+	for (int32_t y = 0; y < src.height; y++)
+		memcpy(dst.getLinePointer(y), src.getLinePointer(y), (size_t)(src.width * src.pixelStride));
+	
+	return image;
+}
+
+/*---------------------------------------------------------------------------*/
+void FrameExporter::Release(const Image& image)
+{
+	const ScopedLock lock(mLock);
+	mSpareImages.push_back(image);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Write
+//   - on one of the pool's threads
+/*---------------------------------------------------------------------------*/
+void FrameExporter::Write(const Image& image, const File& file)
+{
+	gTraceRecorder.SetThreadName("pngEncoder");
+	StTraceScope trace("encodePNG");
+	const int64_t start = Time::getHighResolutionTicks();
+	
+	// FileOutputStream appends to an existing file
+	file.deleteFile();
+	bool ok = false;
+	{
+		FileOutputStream out(file);
+		PNGImageFormat png;
+		ok = (out.openedOk() && png.writeImageToStream(image, out));
+	}
+	
+	if (!ok)
+		printf("frames: could not write %s\n", file.getFullPathName().toRawUTF8());
+	
+	const int64_t now = Time::getHighResolutionTicks();
+	mEncodeTicks += (now - start);
+	mLastWrittenTicks = now;
+	(ok ? mNumWritten : mNumFailed)++;
+	
+	// Finish() may return (and the exporter go away) as soon as this is 0
+	this->Release(image);
+	mFrameWritten.signal();
+	mNumPending--;
+}
+
+/*---------------------------------------------------------------------------*/
+double FrameExporter::GetEncodeMS() const
+{
+	return Time::highResolutionTicksToSeconds(mEncodeTicks) * 1000.0;
+}
+
+/*---------------------------------------------------------------------------*/
+double FrameExporter::GetWallMS() const
+{
+	return (mFirstAddTicks == 0) ? 0.0 : Time::highResolutionTicksToSeconds(mLastWrittenTicks - mFirstAddTicks) * 1000.0;
+}
+
+/*---------------------------------------------------------------------------*/
+double FrameExporter::GetStallMS() const
+{
+	return Time::highResolutionTicksToSeconds(mStallTicks) * 1000.0;
+}
+
+} // pong namespace
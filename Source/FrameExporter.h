@@ -0,0 +1,75 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	FrameExporter.h
+	
+	Writes rendered frames out as numbered PNGs (frame_000000.png, ...), for
+	visual regression checks of headless runs. The render loop only copies
+	the frame into a spare image and queues it - the PNG encoding & file
+	writing happen on a pool of background threads, so they don't slow the
+	loop down unless the encoders fall more than kMaxPending frames behind.
+	
+	The copies are recycled once they've been written, so a long run doesn't
+	allocate a new frame-sized image every tick.
+	
+	usage: SpaceForce --headless --frames-out dir [--encoders N] ...
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <vector>
+
+namespace pong
+{
+
+// FrameExporter
+class FrameExporter
+{
+public:
+	static const int32_t kMaxPending = 16; // frames copied but not yet written
+	
+	// creates dir if it isn't there
+	FrameExporter(const File& dir, int32_t numThreads);
+	~FrameExporter();
+	
+	// queues a copy of frame as frame number n - returns right away unless
+	// the encoders are kMaxPending frames behind
+	void	Add(const Image& frame, int64_t n);
+	
+	// waits for every queued frame to be written
+	void	Finish();
+	
+	int32_t	GetNumThreads() const { return mNumThreads; }
+	int64_t	GetNumWritten() const { return mNumWritten; }
+	int64_t	GetNumFailed() const { return mNumFailed; }
+	
+	double	GetEncodeMS() const;	// summed over all the threads
+	double	GetWallMS() const;		// from the first Add until the last frame was written
+	double	GetStallMS() const;		// Add waiting for the encoders to catch up
+
+private:
+	Image	Acquire(const Image& frame);
+	void	Release(const Image& image);
+	void	Write(const Image& image, const File& file);
+	
+	const File			mDir;
+	const int32_t		mNumThreads;
+	
+	CriticalSection		mLock;
+	std::vector<Image>	mSpareImages; // mLock
+	
+	std::atomic<int32_t> mNumPending;
+	std::atomic<int64_t> mNumWritten;
+	std::atomic<int64_t> mNumFailed;
+	std::atomic<int64_t> mEncodeTicks;
+	std::atomic<int64_t> mFirstAddTicks;
+	std::atomic<int64_t> mLastWrittenTicks;
+	int64_t				mStallTicks = 0;
+	WaitableEvent		mFrameWritten;
+	
+	ThreadPool			mPool; // last, so its threads stop before the rest goes away
+};
+
+} // pong namespace
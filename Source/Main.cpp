@@ -10,6 +10,8 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainComponent.h"
+#include "Simulation.h"
+#include "Benchmark.h"
 
 //==============================================================================
 class SpaceForceApplication  : public JUCEApplication
@@ -26,6 +28,20 @@ public:
     void initialise (const String& commandLine) override
     {
         // This method is where you should put your application's initialisation code..
+		
+		// headless runs never open a window - run the simulation and quit
+		if (commandLine.contains("--headless") || commandLine.contains("--bench") || commandLine.contains("--dump-flight"))
+		{
+			const StringArray args = getCommandLineParameterArray();
+			if (args.contains("--dump-flight"))
+				setApplicationReturnValue(pong::DumpFlightRecording(args));
+			else if (args.contains("--bench"))
+				setApplicationReturnValue(pong::RunBenchmarks(args));
+			else
+				setApplicationReturnValue(pong::RunHeadless(args));
+			quit();
+			return;
+		}
 
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
@@ -67,6 +83,7 @@ public:
         {
             setUsingNativeTitleBar (true);
             setContentOwned (new MainComponent(), true);
+            setResizable (true, false); // the game scales to fit
 
             centreWithSize (getWidth(), getHeight());
             setVisible (true);
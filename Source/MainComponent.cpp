@@ -8,8 +8,14 @@
 
 #include "MainComponent.h"
 #include "SpaceForce.h"
+#include "Trace.h"
+#include "TileRenderer.h"
+#include "PlaylistSource.h"
+#include "MusicLibrary.h"
 #include <random>
 #include <algorithm>
+#include <cmath>
+#include <deque>
 
 std::random_device rd;
 std::mt19937 randomizer(rd());
@@ -18,12 +24,13 @@ std::mt19937 randomizer(rd());
 struct SongInfo
 {
 	std::string mName;
-	int32_t mPosition; // seconds
+	double mPosition; // seconds
 	int32_t mDuration; // seconds
-	File mFile;
-	AudioFormatReader* mReader;
-	AudioFormatReaderSource* mSource;
+	std::string mFileName;
+	File mFile; // once the library's found it
 	double mGain;
+	double mSampleRate = 0; // from the library's scan
+	int64 mLengthInSamples = 0;
 };
 
 namespace
@@ -37,24 +44,146 @@ namespace
 
 	AudioFormatManager formatManager;
 	std::unique_ptr<AudioFormatReaderSource> readerSource;
-	AudioTransportSource transportSource;
+	std::unique_ptr<PlaylistSource> playlist;
 
 	std::vector<SongInfo> musicVector;
-	int32_t musicIndex = -1; // this starts us at 0
-	
-	class MusicTimer : public Timer
+	int32_t musicIndex = -1; // the song that was faded in last
+	
+	// only the playing song & the one after it are open - the rest of the
+	// playlist is just names & files until its turn comes
+	std::unique_ptr<TimeSliceThread> musicReadThread;
+	
+	/*---------------------------------------------------------------------------*/
+	// SongOpener - opens the songs CueSong asks for, and pre-rolls them, on
+	// its own thread - parsing the file's header & waiting for the first read
+	// ahead would hitch the message thread. It can't be musicReadThread, since
+	// the pre-roll waits on that thread.
+	class SongOpener : public Thread
 	{
 	public:
-		MusicTimer(MainComponent* main) : mMain(main) {}
-		virtual void timerCallback() override { mMain->MusicCallback(); }
+		struct Opened
+		{
+			int32_t		mIndex;
+			std::unique_ptr<PlaylistTrack> mTrack; // null if it couldn't be opened
+		};
+		
+		SongOpener() : Thread("musicOpener") {}
+		~SongOpener() { this->stopThread(2000); }
+		
+		void Open(int32_t index, const SongInfo& song)
+		{
+			{
+				const ScopedLock lock(mLock);
+				mRequests.push_back({index, song});
+			}
+			this->notify();
+		}
+		
+		// the songs that have been opened (or failed to) since last time
+		std::deque<Opened> TakeOpened()
+		{
+			std::deque<Opened> opened;
+			const ScopedLock lock(mLock);
+			opened.swap(mOpened);
+			return opened;
+		}
+		
+		virtual void run() override
+		{
+			gTraceRecorder.SetThreadName("musicOpener");
+			while (!this->threadShouldExit())
+			{
+				Request request;
+				{
+					const ScopedLock lock(mLock);
+					if (!mRequests.empty())
+					{
+						request = mRequests.front();
+						mRequests.pop_front();
+					}
+				}
+				
+				if (request.mIndex < 0)
+				{
+					this->wait(-1);
+					continue;
+				}
+				
+				std::unique_ptr<PlaylistTrack> track = this->NewTrack(request.mIndex, request.mSong);
+				const ScopedLock lock(mLock);
+				mOpened.push_back({request.mIndex, std::move(track)});
+			}
+		}
+	
 	private:
-		MainComponent* mMain;
+		struct Request
+		{
+			int32_t		mIndex = -1;
+			SongInfo	mSong;
+		};
+		
+		// plays from the song's position to its end, for up to kMaxSongSeconds
+		// - sized from the library's scan, so only the reader's opened here
+		std::unique_ptr<PlaylistTrack> NewTrack(int32_t index, const SongInfo& song);
+		
+		CriticalSection		mLock;
+		std::deque<Request>	mRequests;	// mLock
+		std::deque<Opened>	mOpened;	// mLock
 	};
 	
-	MusicTimer* musicTimer = nullptr;
+	std::unique_ptr<SongOpener> songOpener;
+	
+	// the audio thread's trace events - registered in prepareToPlay, so the
+	// audio thread never allocates it
+	TraceBuffer* audioTraceBuffer = nullptr;
+	
+	// the songs we'd like to play - they go into musicVector (shuffled) as
+	// the library finds them
+	std::vector<SongInfo> songList;
+	std::unique_ptr<MusicLibrary> musicLibrary;
+	int32_t cuedIndex = -1; // the song cued last, or being opened (CueOpenedSongs may have skipped some to get to it)
+	size_t cueFailures = 0; // songs in a row that couldn't be opened
+	
+	const int32_t kReadAheadSamples = 65536; // per channel, ~1.5 sec
+	const double kMaxSongSeconds = 30;
+	const int32_t kMusicPollMS = 50;
+	
+	// the game draws into this between paints, and only the parts that
+	// changed get repainted (unless run with --full-repaint)
+	Image frameImage;
+	bool useDirtyRects = false;
+	
+	// with --tiles [N] the frame is rasterized on N threads (all the cores if
+	// N is left off) into frameImage, and paint just blits it
+	std::unique_ptr<TileRenderer> tileRenderer;
+	
+	// the game's grid is scaled to fit the window (in 1/16 steps, so the
+	// dirty region's tiles land on whole pixels) and centred in it
+	float renderScale = 1.0f;
+	Point<int> renderOffset;
+	
+	/*---------------------------------------------------------------------------*/
+	float RenderScaleFor(int32_t width, int32_t height)
+	{
+		const float fit = std::min(width / (float)pong->GetGridWidth(), height / (float)pong->GetGridHeight());
+		return std::max(1.0f, std::floor(fit * 16.0f)) / 16.0f;
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// where the grid is in the window
+	Rectangle<int> RenderBounds()
+	{
+		return Rectangle<int>(renderOffset.x, renderOffset.y,
+							  roundToInt(pong->GetGridWidth() * renderScale), roundToInt(pong->GetGridHeight() * renderScale));
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	Colour BackgroundColour()
+	{
+		return Desktop::getInstance().getDefaultLookAndFeel().findColour(ResizableWindow::backgroundColourId);
+	}
 	
 	std::vector<SongInfo> sMusicHistory;
-	double kGainFactor = 1.0;
 	
 	const std::string kLocalMusicFolder = "../../../../Music/";
 	const String kMusicFolder =
@@ -62,20 +191,124 @@ namespace
 		"/Contents/Resources/Music/";
 	
 	//==============================================================================
+	// a pos of 0 starts the song where its music starts
 	void AddSong(std::string name, int32_t pos, int32_t dur, std::string fileName, double gain = 1.0)
 	{
-		File file(kMusicFolder + fileName);
-		if (!file.exists())
-			file = File(kLocalMusicFolder + fileName);
+		songList.push_back({name, (double)pos, dur, fileName, File(), gain});
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// 	METHOD:	SongOpener::NewTrack
+	/*---------------------------------------------------------------------------*/
+	std::unique_ptr<PlaylistTrack> SongOpener::NewTrack(int32_t index, const SongInfo& song)
+	{
+		StTraceScope trace("openSong");
+		AudioFormatReader* reader = formatManager.createReaderFor(song.mFile);
+		if (!reader)
+			return nullptr;
+		
+		const double seconds = std::max(1.0, std::min(kMaxSongSeconds, (song.mLengthInSamples / song.mSampleRate) - song.mPosition));
+		const double sampleRate = reader->sampleRate;
+		BufferingAudioSource* source = new BufferingAudioSource(new AudioFormatReaderSource(reader, true), *musicReadThread, true, kReadAheadSamples);
+		return playlist->NewTrack(index, source, sampleRate, (int64)(song.mPosition * sampleRate), seconds, (float)song.mGain);
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// 	METHOD:	CueSong
+	//   - has song index opened (reading ahead from its position right away)
+	//     - it's cued after the one that's cued now once it's ready (see
+	//     CueOpenedSongs), and counts as cued until then
+	/*---------------------------------------------------------------------------*/
+	void CueSong(int32_t index)
+	{
+		songOpener->Open(index, musicVector[index]);
+		cuedIndex = index;
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// 	METHOD:	CueOpenedSongs
+	//   - if a song couldn't be opened the one after it is tried instead
+	/*---------------------------------------------------------------------------*/
+	void CueOpenedSongs()
+	{
+		for (SongOpener::Opened& opened : songOpener->TakeOpened())
+		{
+			if (opened.mTrack)
+			{
+				playlist->Cue(std::move(opened.mTrack));
+				cueFailures = 0;
+				continue;
+			}
+			
+			printf("music: could not open %s\n", musicVector[opened.mIndex].mFile.getFullPathName().toRawUTF8());
+			if (++cueFailures < musicVector.size())
+				CueSong((opened.mIndex + 1) % musicVector.size());
+		}
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// 	METHOD:	SongStarted
+	//   - the playlist's started fading song index in - the one after it is
+	//     cued now, so it's read ahead long before its turn
+	/*---------------------------------------------------------------------------*/
+	void SongStarted(int32_t index)
+	{
+		musicIndex = index;
+		const SongInfo& song = musicVector[index];
+		sMusicHistory.push_back(song);
+		pong->SetSongName(song.mName);
 		
-		if (file.exists())
+		CueSong((index + 1) % musicVector.size());
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// 	METHOD:	AddFoundSongs
+	//   - each song the library's found goes in at random somewhere after both
+	//     the playing song & the one that's actually cued (so the indexes the
+	//     playlist has for them stay put) - the first one's cued right away.
+	//     The library finds them in songList's (shuffled) order.
+	/*---------------------------------------------------------------------------*/
+	void AddFoundSongs()
+	{
+		for (const MusicFileInfo& info : musicLibrary->TakeFound())
 		{
-			AudioFormatReader* reader = formatManager.createReaderFor(file);
-			AudioFormatReaderSource* source = new AudioFormatReaderSource(reader, true);
-			musicVector.push_back({name, pos, dur, file, reader, source, gain});
+			for (const SongInfo& listed : songList)
+			{
+				if (listed.mFileName != info.mFile.getFileName().toStdString())
+					continue;
+				
+				SongInfo song = listed;
+				song.mFile = info.mFile;
+				song.mSampleRate = info.mSampleRate;
+				song.mLengthInSamples = info.mLengthInSamples;
+				if (song.mPosition <= 0)
+					song.mPosition = (info.mStartSample / info.mSampleRate);
+				
+				const int32_t size = (int32_t)musicVector.size();
+				const int32_t lowest = std::max(1, std::max(musicIndex, cuedIndex) + 1);
+				const int32_t index = (lowest < size) ? std::uniform_int_distribution<int32_t>(lowest, size)(randomizer) : size;
+				musicVector.insert(musicVector.begin() + index, song);
+				
+				if (cuedIndex < 0)
+					CueSong(index);
+			}
 		}
 	}
 	
+	// picks up what the playlist's done on the audio thread
+	class MusicTimer : public Timer
+	{
+	public:
+		virtual void timerCallback() override
+		{
+			playlist->Update(SongStarted);
+			CueOpenedSongs();
+			AddFoundSongs();
+		}
+	};
+	
+	MusicTimer* musicTimer = nullptr;
+	
 	ApplicationProperties appProperties;
 }
 
@@ -85,38 +318,8 @@ int64_t min64(int64_t a, int64_t b) { return a < b ? a : b; }
 //==============================================================================
 void MainComponent::MusicCallback()
 {
-	if (musicVector.size() <= 0)
-		return;
-	
-	// update index
-	musicIndex = ((musicIndex + 1) % musicVector.size());
-	
-	SongInfo& song = musicVector[musicIndex];
-	sMusicHistory.push_back(song);
-	
-	if (song.mReader)
-	{
-		transportSource.setSource(song.mSource, 0, nullptr, song.mReader->sampleRate);
-		
-		// used to pass in the song's sr, that worked fine for a while, then one day
-		// it stopped working and everything played too fast - so we now pass in
-		// 48000 - not sure what's going on here
-		const double sr = 48000; // song.mReader->sampleRate
-		this->prepareToPlay(512, sr);
-		transportSource.setPosition(song.mPosition);
-		kGainFactor = song.mGain;
-		transportSource.start();
-	}
-	
-	pong->SetSongName(song.mName);
-	
-	// schedule the next one based on the duration specified
-	// this will cancel the current scheduled event and re-start it
-	const int64_t fileLengthSeconds = song.mReader->lengthInSamples * song.mReader->sampleRate;
-	int32_t secondsUntilNext = (int32_t)fileLengthSeconds; //(const int32_t)min64(fileLengthSeconds, song.mDuration);
-	if (secondsUntilNext > 30)
-		secondsUntilNext = 30;
-	musicTimer->startTimer(secondsUntilNext * 1000);
+	StTraceScope trace("musicCallback");
+	playlist->Skip();
 }
 
 //==============================================================================
@@ -132,6 +335,7 @@ void MainComponent::RotaryCallback(int32_t val)
 //==============================================================================
 void MainComponent::HighScoreCallback(std::string val)
 {
+	StTraceScope trace("highScoreWrite");
 	highScoreFile.replaceWithText(val);
 }
 
@@ -141,6 +345,24 @@ MainComponent::MainComponent()
 	triggerAsyncUpdate();
 	pong = IPongView::Create();
 	setSize(pong->GetGridWidth(), pong->GetGridHeight());
+	
+	const StringArray args = JUCEApplication::getCommandLineParameterArray();
+	useDirtyRects = !args.contains("--full-repaint");
+	if (useDirtyRects)
+		pong->SetDirtyRectsEnabled(true, BackgroundColour());
+	
+	const int32_t tilesIndex = args.indexOf("--tiles");
+	if (tilesIndex >= 0)
+	{
+		const int32_t numThreads = (tilesIndex + 1 < args.size()) ? args[tilesIndex + 1].getIntValue() : 0;
+		tileRenderer.reset(new TileRenderer(numThreads > 0 ? numThreads : SystemStats::getNumCpus()));
+	}
+	
+	if (useDirtyRects || tileRenderer)
+	{
+		frameImage = Image(Image::RGB, RenderBounds().getWidth(), RenderBounds().getHeight(), true);
+		this->setOpaque(true);
+	}
 	this->startTimer(pong->GetRefreshrateMS());
 	srand((int32_t)time(nullptr));
 	
@@ -155,10 +377,8 @@ MainComponent::MainComponent()
 	
 	this->RotaryCallback(0);
 	
-	const int32_t sliderWidth = 140;
-	const int32_t sliderHeight = 140;
-	const int32_t sliderY = 80;
-	rotarySlider->setBounds(pong->GetGridWidth()/2 - sliderWidth/2, sliderY, sliderWidth, sliderHeight);
+	// setSize above ran before the slider existed
+	this->resized();
 	
 	// install callbacks
 	pong->InstallRotaryCallback([this](int32_t val) { this->RotaryCallback(val); });
@@ -166,8 +386,17 @@ MainComponent::MainComponent()
 	pong->InstallHighScoreCallback([this](std::string val) { this->HighScoreCallback(val); });
 
 	// audio
+	playlist.reset(new PlaylistSource());
+	const int32_t crossfadeIndex = args.indexOf("--crossfade");
+	if (crossfadeIndex >= 0 && crossfadeIndex + 1 < args.size())
+		playlist->SetCrossfadeSeconds(args[crossfadeIndex + 1].getDoubleValue());
+	
 	setAudioChannels(0, 2);
 	formatManager.registerBasicFormats();
+	musicReadThread.reset(new TimeSliceThread("musicReader"));
+	musicReadThread->startThread();
+	songOpener.reset(new SongOpener());
+	songOpener->startThread();
 	
 	const int32_t gDuration = 30;
 	
@@ -207,12 +436,23 @@ MainComponent::MainComponent()
 	AddSong("Solar", 0, 60, "Solar.mp3");
 	AddSong("Sunday", 75, 40, "Sunday.aiff"); // make me mp3
 	
-	// shuffle the vector
-	std::shuffle(musicVector.begin(), musicVector.end(), randomizer);
+	// find the music in the background - it starts with the first song found,
+	// so the list is shuffled first (the cached files are all found at once,
+	// in this order)
+	std::shuffle(songList.begin(), songList.end(), randomizer);
+	StringArray fileNames;
+	for (const SongInfo& song : songList)
+	{
+		if (!fileNames.contains(song.mFileName))
+			fileNames.add(song.mFileName);
+	}
+	
+	const File cacheFile = File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile("SpaceForce").getChildFile("MusicCache.dat");
+	musicLibrary.reset(new MusicLibrary({File(kMusicFolder), File(kLocalMusicFolder)}, fileNames, cacheFile));
+	musicLibrary->Start();
 	
-	// start the music
-	musicTimer = new MusicTimer(this);
-	this->MusicCallback();
+	musicTimer = new MusicTimer();
+	musicTimer->startTimer(kMusicPollMS);
 	
 	// read in the highScore file
 	String s = highScoreFile.loadFileAsString();
@@ -271,9 +511,13 @@ MainComponent::MainComponent()
 MainComponent::~MainComponent()
 {
 	pong.reset();
-	transportSource.stop();
 	shutdownAudio();
 	delete musicTimer;
+	musicLibrary.reset();
+	songOpener.reset(); // its tracks read from musicReadThread
+	
+	playlist.reset();
+	musicReadThread.reset();
 }
 
 //==============================================================================
@@ -283,21 +527,81 @@ void MainComponent::paint (Graphics& g)
     g.setColour(Colours::lawngreen);
     //g.drawText ("Space Force", getLocalBounds(), Justification::centred, true);
 	
-	pong->Draw(g);
+	StTraceScope trace("paint");
+	if (frameImage.isValid())
+	{
+		// the bars either side of the grid, if the window's a different shape
+		{
+			Graphics::ScopedSaveState state(g);
+			g.excludeClipRegion(RenderBounds());
+			g.fillAll(BackgroundColour());
+		}
+		
+		g.drawImageAt(frameImage, renderOffset.x, renderOffset.y);
+	}
+	else
+	{
+		g.setOrigin(renderOffset.x, renderOffset.y);
+		pong->Draw(g);
+	}
 }
 
 //==============================================================================
 void MainComponent::resized()
 {
-    // This is called when the MainComponent is resized.
-    // If you add any child components, this is where you should
-    // update their positions.
+	// the sprites for the new scale are made in the background
+	renderScale = RenderScaleFor(this->getWidth(), this->getHeight());
+	pong->SetRenderScale(renderScale);
+	
+	const Rectangle<int> grid = RenderBounds();
+	renderOffset = {(this->getWidth() - grid.getWidth()) / 2, (this->getHeight() - grid.getHeight()) / 2};
+	
+	if (frameImage.isValid() && frameImage.getBounds() != grid.withZeroOrigin())
+		frameImage = Image(Image::RGB, grid.getWidth(), grid.getHeight(), true);
+	
+	// the score dial is over the game, so it's placed in grid coordinates too
+	if (rotarySlider)
+	{
+		const float sliderWidth = 140;
+		const float sliderHeight = 140;
+		const float sliderY = 80;
+		const Rectangle<float> slider((pong->GetGridWidth() - sliderWidth) / 2, sliderY, sliderWidth, sliderHeight);
+		rotarySlider->setBounds((slider * renderScale).getSmallestIntegerContainer().translated(renderOffset.x, renderOffset.y));
+	}
+	
+	this->repaint();
 }
 
 //==============================================================================
 void MainComponent::timerCallback()
 {
-	this->repaint();
+	if (!frameImage.isValid())
+	{
+		this->repaint();
+		return;
+	}
+	
+	auto draw = [](Graphics& g)
+	{
+		if (!useDirtyRects)
+			g.fillAll(BackgroundColour());
+		
+		g.setFont(Font(16.0f));
+		g.setColour(Colours::lawngreen);
+		pong->Draw(g);
+	};
+	
+	if (tileRenderer)
+		tileRenderer->Render(frameImage, draw);
+	else
+	{
+		Graphics g(frameImage);
+		draw(g);
+	}
+	
+	// (all of it, without dirty rects)
+	for (const Rectangle<int>& r : pong->GetDirtyRectangles())
+		this->repaint((r.toFloat() * renderScale).getSmallestIntegerContainer().translated(renderOffset.x, renderOffset.y));
 }
 
 //==============================================================================
@@ -311,29 +615,26 @@ void MainComponent::handleAsyncUpdate()
 //==============================================================================
 void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
-	transportSource.prepareToPlay (samplesPerBlockExpected, sampleRate);
+	if (gTraceRecorder.IsEnabled() && !audioTraceBuffer)
+		audioTraceBuffer = gTraceRecorder.ReserveThreadBuffer("audio");
+	
+	playlist->prepareToPlay (samplesPerBlockExpected, sampleRate);
 }
 
 //==============================================================================
 void MainComponent::getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill)
 {
-	transportSource.getNextAudioBlock(bufferToFill);
+	if (audioTraceBuffer)
+		gTraceRecorder.UseThreadBuffer(audioTraceBuffer);
+	StTraceScope trace("audioBlock");
 	
-	if (kGainFactor != 1.0)
-	{
-		for (auto channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
-		{
-			auto* buffer = bufferToFill.buffer->getWritePointer (channel, bufferToFill.startSample);
-			for (auto sample = 0; sample < bufferToFill.numSamples; ++sample)
-				buffer[sample] *= kGainFactor;
-		}
-	}
+	playlist->getNextAudioBlock(bufferToFill);
 }
 
 //==============================================================================
 void MainComponent::releaseResources()
 {
-	transportSource.releaseResources();
+	playlist->releaseResources();
 }
 
 /** A list of the command IDs that this demo can perform. */
@@ -0,0 +1,254 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	MusicLibrary.cpp
+*****************************************************************************/
+
+#include "MusicLibrary.h"
+#include "Trace.h"
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+	const char kCacheMagic[4] = {'S', 'F', 'M', 'C'};
+	const uint32_t kCacheVersion = 1;
+	
+	const double kMaxLeadInSeconds = 10;	// where we give up looking for the start
+	const float kSilence = 0.001f;			// -60 dB
+	const int32_t kReadChunk = 8192;
+	
+	// MusicCacheHeader - at the start of the cache file, then mNumEntries
+	// MusicCacheEntrys (all plain old data, read & written as is)
+	struct MusicCacheHeader
+	{
+		char		mMagic[4];	// "SFMC"
+		uint32_t	mVersion;
+		uint32_t	mEntrySize;
+		uint32_t	mNumEntries;
+	};
+	
+	struct MusicCacheEntry
+	{
+		int64_t		mPathHash;	// the full path's String::hashCode64
+		int64_t		mSize;
+		int64_t		mModified;
+		double		mSampleRate;
+		int64_t		mLengthInSamples;
+		int64_t		mStartSample;
+	};
+	
+	/*---------------------------------------------------------------------------*/
+	// 	METHOD:	LoadCache
+	//   - by path hash - empty if the file's missing or isn't one of ours
+	/*---------------------------------------------------------------------------*/
+	std::map<int64_t, MusicCacheEntry> LoadCache(const File& file)
+	{
+		std::map<int64_t, MusicCacheEntry> cache;
+		MemoryBlock data;
+		if (!file.existsAsFile() || !file.loadFileAsData(data) || data.getSize() < sizeof(MusicCacheHeader))
+			return cache;
+		
+		const MusicCacheHeader* header = static_cast<const MusicCacheHeader*>(data.getData());
+		if (memcmp(header->mMagic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header->mVersion != kCacheVersion ||
+			header->mEntrySize != sizeof(MusicCacheEntry) ||
+			data.getSize() < sizeof(MusicCacheHeader) + (header->mNumEntries * sizeof(MusicCacheEntry)))
+			return cache;
+		
+		const MusicCacheEntry* entries = reinterpret_cast<const MusicCacheEntry*>(header + 1);
+		for (uint32_t k = 0; k < header->mNumEntries; k++)
+			cache[entries[k].mPathHash] = entries[k];
+		
+		return cache;
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	void SaveCache(const File& file, const std::vector<MusicFileInfo>& infos)
+	{
+		std::vector<char> data(sizeof(MusicCacheHeader) + (infos.size() * sizeof(MusicCacheEntry)));
+		MusicCacheHeader* header = reinterpret_cast<MusicCacheHeader*>(data.data());
+		memcpy(header->mMagic, kCacheMagic, sizeof(kCacheMagic));
+		header->mVersion = kCacheVersion;
+		header->mEntrySize = sizeof(MusicCacheEntry);
+		header->mNumEntries = (uint32_t)infos.size();
+		
+		MusicCacheEntry* entries = reinterpret_cast<MusicCacheEntry*>(header + 1);
+		for (size_t k = 0; k < infos.size(); k++)
+		{
+			const MusicFileInfo& info = infos[k];
+			entries[k] = {info.mFile.getFullPathName().hashCode64(), info.mSize, info.mModified,
+						  info.mSampleRate, info.mLengthInSamples, info.mStartSample};
+		}
+		
+		file.getParentDirectory().createDirectory();
+		if (!file.replaceWithData(data.data(), data.size()))
+			printf("music: could not write %s\n", file.getFullPathName().toRawUTF8());
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// 	METHOD:	FindStart
+	//   - the first sample in the lead-in that isn't silence (or 0)
+	/*---------------------------------------------------------------------------*/
+	int64 FindStart(AudioFormatReader& reader)
+	{
+		const int64 end = std::min(reader.lengthInSamples, (int64)(kMaxLeadInSeconds * reader.sampleRate));
+		AudioBuffer<float> buffer(2, kReadChunk);
+		for (int64 pos = 0; pos < end; pos += kReadChunk)
+		{
+			const int32_t num = (int32_t)std::min((int64)kReadChunk, end - pos);
+			reader.read(&buffer, 0, num, pos, true, true);
+			
+			int32_t first = num;
+			for (int32_t c = 0; c < buffer.getNumChannels(); c++)
+			{
+				const float* samples = buffer.getReadPointer(c);
+				for (int32_t k = 0; k < first; k++)
+				{
+					if (fabsf(samples[k]) > kSilence)
+					{
+						first = k;
+						break;
+					}
+				}
+			}
+			
+			if (first < num)
+				return (pos + first);
+		}
+		
+		return 0;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// Scanner
+class MusicLibrary::Scanner : public Thread
+{
+public:
+	Scanner(MusicLibrary& library) : Thread("musicScanner"), mLibrary(library) {}
+	
+	virtual void run() override
+	{
+		gTraceRecorder.SetThreadName("musicScanner");
+		mLibrary.Scan();
+	}
+
+private:
+	MusicLibrary& mLibrary;
+};
+
+/*---------------------------------------------------------------------------*/
+MusicLibrary::MusicLibrary(const std::vector<File>& folders, const StringArray& fileNames, const File& cacheFile) :
+	mFolders(folders),
+	mFileNames(fileNames),
+	mCacheFile(cacheFile)
+{
+}
+
+/*---------------------------------------------------------------------------*/
+MusicLibrary::~MusicLibrary()
+{
+	if (mScanner)
+		mScanner->stopThread(2000);
+}
+
+/*---------------------------------------------------------------------------*/
+void MusicLibrary::Start()
+{
+	mScanner.reset(new Scanner(*this));
+	mScanner->startThread();
+}
+
+/*---------------------------------------------------------------------------*/
+std::vector<MusicFileInfo> MusicLibrary::TakeFound()
+{
+	std::vector<MusicFileInfo> found;
+	const ScopedLock lock(mLock);
+	found.swap(mFound);
+	return found;
+}
+
+/*---------------------------------------------------------------------------*/
+void MusicLibrary::Found(const MusicFileInfo& info)
+{
+	if (info.mSampleRate <= 0)
+		return;
+	
+	const ScopedLock lock(mLock);
+	mFound.push_back(info);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Scan
+//   - on the scanner thread. The cache is only written if something's
+//     changed (a file was read, or one that was in it has gone).
+/*---------------------------------------------------------------------------*/
+void MusicLibrary::Scan()
+{
+	StTraceScope trace("scanMusic");
+	const int64_t start = Time::getHighResolutionTicks();
+	const std::map<int64_t, MusicCacheEntry> cache = LoadCache(mCacheFile);
+	
+	// the cached ones can be played right away
+	std::vector<MusicFileInfo> infos;
+	std::vector<MusicFileInfo> toRead;
+	for (const String& name : mFileNames)
+	{
+		for (const File& folder : mFolders)
+		{
+			const File file = folder.getChildFile(name);
+			if (!file.existsAsFile())
+				continue;
+			
+			MusicFileInfo info = {file, file.getSize(), file.getLastModificationTime().toMilliseconds(), 0, 0, 0};
+			const auto it = cache.find(file.getFullPathName().hashCode64());
+			if (it != cache.end() && it->second.mSize == info.mSize && it->second.mModified == info.mModified)
+			{
+				info.mSampleRate = it->second.mSampleRate;
+				info.mLengthInSamples = it->second.mLengthInSamples;
+				info.mStartSample = it->second.mStartSample;
+				infos.push_back(info);
+				this->Found(info);
+			}
+			else
+			{
+				toRead.push_back(info);
+			}
+			break;
+		}
+	}
+	const size_t numCached = infos.size();
+	
+	AudioFormatManager formats;
+	formats.registerBasicFormats();
+	for (MusicFileInfo& info : toRead)
+	{
+		if (mScanner->threadShouldExit())
+			return;
+		
+		StTraceScope trace("readMusicFile");
+		std::unique_ptr<AudioFormatReader> reader(formats.createReaderFor(info.mFile));
+		if (reader)
+		{
+			info.mSampleRate = reader->sampleRate;
+			info.mLengthInSamples = reader->lengthInSamples;
+			info.mStartSample = FindStart(*reader);
+		}
+		else
+		{
+			printf("music: could not read %s\n", info.mFile.getFullPathName().toRawUTF8());
+		}
+		
+		infos.push_back(info);
+		this->Found(info);
+	}
+	
+	if (!toRead.empty() || numCached != cache.size())
+		SaveCache(mCacheFile, infos);
+	
+	printf("music: %d files (%d cached) in %.1f ms\n", (int32_t)infos.size(), (int32_t)numCached,
+		   Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0);
+}
@@ -0,0 +1,67 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	MusicLibrary.h
+	
+	Finds the playlist's music files and works out what the player needs
+	to know about each one - its sample rate, its length, and where the
+	music starts (past any silence at the top) - on a background thread,
+	so none of it holds up the window opening.
+	
+	What it finds is kept in a small cache file (MusicCache.dat, in the
+	SpaceForce folder in the user's application data), keyed on the file's
+	path, size & modification time - so after the first launch a file is
+	only opened again if it's changed. The cached files are handed over
+	first, and then the others as each one is read, so the music can start
+	as soon as there's anything to play.
+	
+	This lives in the global namespace (like IPongView) so MainComponent,
+	which has its own 'pong', can use it.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <memory>
+#include <vector>
+
+// MusicFileInfo
+struct MusicFileInfo
+{
+	File		mFile;
+	int64		mSize;
+	int64		mModified;		// ms since 1970
+	double		mSampleRate;	// 0 if it couldn't be read
+	int64		mLengthInSamples;
+	int64		mStartSample;	// the first that isn't silence
+};
+
+// MusicLibrary
+class MusicLibrary
+{
+public:
+	// the music's in the first folder that has each of fileNames
+	MusicLibrary(const std::vector<File>& folders, const StringArray& fileNames, const File& cacheFile);
+	~MusicLibrary();
+	
+	void	Start();
+	
+	// message thread - the files that have been found since the last call
+	// (that can be played)
+	std::vector<MusicFileInfo> TakeFound();
+
+private:
+	class Scanner;
+	
+	void	Scan();
+	void	Found(const MusicFileInfo& info);
+	
+	const std::vector<File>	mFolders;
+	const StringArray		mFileNames;
+	const File				mCacheFile;
+	
+	CriticalSection				mLock;
+	std::vector<MusicFileInfo>	mFound; // mLock
+	
+	std::unique_ptr<Scanner>	mScanner;
+};
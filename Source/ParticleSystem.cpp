@@ -0,0 +1,196 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	ParticleSystem.cpp
+*****************************************************************************/
+
+#include "ParticleSystem.h"
+#include "DirtyRegion.h"
+#include <algorithm>
+#include <math.h>
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+ParticleSystem::ParticleSystem() :
+	mX(kMaxParticles),
+	mY(kMaxParticles),
+	mVelX(kMaxParticles),
+	mVelY(kMaxParticles),
+	mAccX(kMaxParticles),
+	mGravity(kMaxParticles),
+	mSize(kMaxParticles),
+	mExpireMS(kMaxParticles),
+	mColour(kMaxParticles),
+	mAlive(kMaxParticles),
+	mPalette{Colours::lawngreen, Colours::ivory, Colours::blue, Colours::orange, Colours::yellow}
+{
+}
+
+/*---------------------------------------------------------------------------*/
+void ParticleSystem::Add(const Particle& p)
+{
+	if (mHead - mTail == (uint32_t)kMaxParticles)
+	{
+		// full - the oldest goes, and what it left on the screen needs clearing
+		const int32_t k = this->Index(mTail++);
+		if (mAlive[k])
+		{
+			mNumLive--;
+			if (mDirtyRegion)
+				mDirtyRegion->Add(this->DrawnBounds(k));
+		}
+	}
+	
+	const int32_t k = this->Index(mHead++);
+	mX[k] = p.mX;
+	mY[k] = p.mY;
+	mVelX[k] = p.mVelX;
+	mVelY[k] = p.mVelY;
+	mAccX[k] = p.mAccX;
+	mGravity[k] = p.mGravity;
+	mSize[k] = p.mSize;
+	mExpireMS[k] = p.mExpireMS;
+	mColour[k] = (uint8_t)jlimit(0, kNumColours - 1, p.mColour);
+	mAlive[k] = 1;
+	mNumLive++;
+}
+
+/*---------------------------------------------------------------------------*/
+void ParticleSystem::Clear()
+{
+	if (mDirtyRegion)
+		this->AddDirtyBounds();
+	
+	mHead = mTail = 0;
+	mNumLive = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Animate
+//   - the live part of the ring is at most two contiguous spans
+/*---------------------------------------------------------------------------*/
+void ParticleSystem::Animate(float diffSec, int64_t nowMS, int32_t width, int32_t height)
+{
+	if (mHead == mTail)
+		return;
+	
+	// where they were
+	if (mDirtyRegion)
+		this->AddDirtyBounds();
+	
+	const int32_t begin = this->Index(mTail);
+	const int32_t num = (int32_t)(mHead - mTail);
+	const int32_t first = std::min(num, kMaxParticles - begin);
+	
+	mNumLive = 0;
+	this->AnimateSpan(begin, first, diffSec, nowMS, width, height);
+	this->AnimateSpan(0, num - first, diffSec, nowMS, width, height);
+	
+	// retire the dead ones at the tail - the oldest usually expire first
+	while (mTail != mHead && !mAlive[this->Index(mTail)])
+		mTail++;
+	
+	// where they are now
+	if (mDirtyRegion)
+		this->AddDirtyBounds();
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	AnimateSpan
+//   - the same integration as CObject::CalcPosition, minus the special cases
+/*---------------------------------------------------------------------------*/
+void ParticleSystem::AnimateSpan(int32_t begin, int32_t num, float diffSec, int64_t nowMS, int32_t width, int32_t height)
+{
+	if (num <= 0)
+		return;
+	
+	float* const x = &mX[begin];
+	float* const y = &mY[begin];
+	float* const velX = &mVelX[begin];
+	float* const velY = &mVelY[begin];
+	float* const accX = &mAccX[begin];
+	const int64_t* const expireMS = &mExpireMS[begin];
+	uint8_t* const alive = &mAlive[begin];
+	
+	// vertical - gravity into velocity, velocity into position
+	FloatVectorOperations::addWithMultiply(velY, &mGravity[begin], diffSec, num);
+	FloatVectorOperations::addWithMultiply(y, velY, diffSec, num);
+	
+	// horizontal - CalcPosition's 'friction': the acceleration's sign flips
+	// every frame the fragment is moving right (so it mostly cancels out),
+	// then the velocity is clamped to zero when it gets close (no branches,
+	// so the compiler can vectorize it)
+	for (int32_t k = 0; k < num; k++)
+	{
+		accX[k] *= (velX[k] > 0 ? -1.0f : 1.0f);
+		const float v = velX[k] + (accX[k] * diffSec);
+		velX[k] = (fabsf(v) < 1.0f ? 0.0f : v);
+	}
+	FloatVectorOperations::addWithMultiply(x, velX, diffSec, num);
+	
+	// the same lifetime rules as CObject::IsAlive
+	const float left = -10.0f, right = (float)(width + 10), bottom = (float)height;
+	int32_t numLive = 0;
+	for (int32_t k = 0; k < num; k++)
+	{
+		alive[k] &= (uint8_t)((nowMS <= expireMS[k]) & (y[k] < bottom) & (x[k] >= left) & (x[k] <= right));
+		numLive += alive[k];
+	}
+	
+	mNumLive += numLive;
+}
+
+/*---------------------------------------------------------------------------*/
+void ParticleSystem::AddDirtyBounds()
+{
+	for (uint32_t n = mTail; n != mHead; n++)
+	{
+		const int32_t k = this->Index(n);
+		if (mAlive[k])
+			mDirtyRegion->Add(this->DrawnBounds(k));
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DrawnBounds
+//   - the pixels particle k's antialiased dot touches
+/*---------------------------------------------------------------------------*/
+Rectangle<int> ParticleSystem::DrawnBounds(int32_t k) const
+{
+	const int32_t size = (int32_t)ceilf(mSize[k]) + 3;
+	return {(int32_t)floorf(mX[k]) - 1, (int32_t)floorf(mY[k]) - 1, size, size};
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Draw
+//   - sort the dots into one path per colour, then fill each path once
+/*---------------------------------------------------------------------------*/
+void ParticleSystem::Draw(Graphics& g)
+{
+	if (mNumLive == 0)
+		return;
+	
+	for (Path& p : mPaths)
+		p.clear();
+	
+	for (uint32_t n = mTail; n != mHead; n++)
+	{
+		const int32_t k = this->Index(n);
+		if (mAlive[k])
+			mPaths[mColour[k]].addEllipse(mX[k], mY[k], mSize[k], mSize[k]);
+	}
+	
+	for (int32_t c = 0; c < kNumColours; c++)
+	{
+		if (mPaths[c].isEmpty())
+			continue;
+		
+		g.setColour(mPalette[c]);
+		g.fillPath(mPaths[c]);
+	}
+}
+
+} // pong namespace
@@ -0,0 +1,102 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	ParticleSystem.h
+	
+	Explosion fragments. There can be thousands of them at once (DoExplosions
+	fires 70 explosions in one go), and all they do is fly, fall, expire and
+	get drawn as dots - so instead of a CObject each (and a pool slot, and a
+	turn in the collision loops) they live here, one array per field.
+	
+	The update is a few straight passes over the arrays (FloatVectorOperations
+	for the integration), and the draw is one path fill per colour. Particles
+	are added at the head of a ring and expire from the tail - the ones that
+	die early (off the screen) are skipped until the tail catches up to them.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <vector>
+
+namespace pong
+{
+
+class DirtyRegion;
+
+// Particle - what Add needs to know about a new one
+struct Particle
+{
+	float		mX;
+	float		mY;
+	float		mVelX;
+	float		mVelY;
+	float		mAccX;		// horizontal acceleration (see AnimateSpan)
+	float		mGravity;	// vertical acceleration
+	int64_t		mExpireMS;	// gNowMS it dies at
+	int32_t		mColour;	// index into the palette
+	float		mSize;		// diameter
+};
+
+// ParticleSystem
+class ParticleSystem
+{
+public:
+	static const int32_t kMaxParticles = 16384; // a power of 2, for the ring
+	
+	// the palette - plain fragments use the first kNumFragmentColours, ship
+	// fragments use all of them
+	static const int32_t kNumFragmentColours = 2;
+	static const int32_t kNumColours = 5;
+	
+	ParticleSystem();
+	
+	// when full, the oldest particle makes room for the new one
+	void	Add(const Particle& p);
+	void	Clear();
+	
+	// moves everything diffSec & retires the particles that expired (at nowMS)
+	// or left the bottom or sides of a width x height screen
+	void	Animate(float diffSec, int64_t nowMS, int32_t width, int32_t height);
+	
+	// one fillPath per colour, in g's clip
+	void	Draw(Graphics& g);
+	
+	// Animate marks where the particles were & where they moved to
+	void	SetDirtyRegion(DirtyRegion* region) { mDirtyRegion = region; }
+	
+	// live particles, as of the last Add or Animate
+	int32_t	GetNumParticles() const { return mNumLive; }
+
+private:
+	int32_t	Index(uint32_t n) const { return (int32_t)(n & (kMaxParticles - 1)); }
+	
+	void	AnimateSpan(int32_t begin, int32_t num, float diffSec, int64_t nowMS, int32_t width, int32_t height);
+	void	AddDirtyBounds();
+	Rectangle<int> DrawnBounds(int32_t k) const;
+	
+	// SoA - index k in each array is one particle
+	std::vector<float>		mX;
+	std::vector<float>		mY;
+	std::vector<float>		mVelX;
+	std::vector<float>		mVelY;
+	std::vector<float>		mAccX;
+	std::vector<float>		mGravity;
+	std::vector<float>		mSize;
+	std::vector<int64_t>	mExpireMS;
+	std::vector<uint8_t>	mColour;
+	std::vector<uint8_t>	mAlive;
+	
+	// the ring - mTail <= live particles < mHead (free-running counters)
+	uint32_t	mHead = 0;
+	uint32_t	mTail = 0;
+	int32_t		mNumLive = 0;
+	
+	Colour		mPalette[kNumColours];
+	Path		mPaths[kNumColours]; // reused each Draw
+	
+	// only set when the view is drawing dirty rects
+	DirtyRegion* mDirtyRegion = nullptr;
+};
+
+} // pong namespace
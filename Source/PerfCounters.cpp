@@ -0,0 +1,179 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	PerfCounters.cpp
+*****************************************************************************/
+
+#include "PerfCounters.h"
+
+#if JUCE_LINUX
+	#include <linux/perf_event.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+	#include <errno.h>
+	#include <string.h>
+#endif
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+const char* CounterName(HardwareCounter counter)
+{
+	switch (counter)
+	{
+		case eCounterCycles:		return "cycles";
+		case eCounterInstructions:	return "instructions";
+		case eCounterL1DMisses:		return "l1dMisses";
+		case eCounterLLCMisses:		return "llcMisses";
+		case eCounterBranchMisses:	return "branchMisses";
+		default:					return "";
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+HardwareCounters::HardwareCounters() :
+	mLeaderFD(-1),
+	mNumSlots(0)
+{
+	for (int32_t k = 0; k < eNumHardwareCounters; k++)
+		mFDs[k] = mSlots[k] = -1;
+}
+
+#if JUCE_LINUX
+
+namespace
+{
+	/*---------------------------------------------------------------------------*/
+	void AttrForCounter(HardwareCounter counter, perf_event_attr& attr)
+	{
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		
+		static const uint64_t kL1DReadMiss = (PERF_COUNT_HW_CACHE_L1D |
+											  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+											  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+		switch (counter)
+		{
+			case eCounterCycles:		attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+			case eCounterInstructions:	attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+			case eCounterLLCMisses:		attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+			case eCounterBranchMisses:	attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+			case eCounterL1DMisses:		attr.type = PERF_TYPE_HW_CACHE; attr.config = kL1DReadMiss; break;
+			default: break;
+		}
+		
+		// user space only - this is what perf_event_paranoid 2 still allows
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = (PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING);
+		attr.disabled = (counter == eCounterCycles); // the leader starts the group
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	int32_t OpenCounter(perf_event_attr& attr, int32_t groupFD)
+	{
+		// this thread, any cpu
+		return (int32_t)syscall(__NR_perf_event_open, &attr, 0, -1, groupFD, 0);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Open
+/*---------------------------------------------------------------------------*/
+bool HardwareCounters::Open(String& error)
+{
+	if (this->IsOpen())
+		return true;
+	
+	perf_event_attr attr;
+	AttrForCounter(eCounterCycles, attr);
+	mLeaderFD = OpenCounter(attr, -1);
+	if (mLeaderFD < 0)
+	{
+		const int32_t err = errno;
+		error = String("perf_event_open failed: ") + strerror(err);
+		if (err == EACCES || err == EPERM)
+			error += " (see /proc/sys/kernel/perf_event_paranoid)";
+		else if (err == ENOENT || err == EOPNOTSUPP)
+			error += " (no hardware counters - virtual machine?)";
+		return false;
+	}
+	
+	mFDs[eCounterCycles] = mLeaderFD;
+	mSlots[eCounterCycles] = mNumSlots++;
+	
+	// the rest are optional
+	for (int32_t k = eCounterCycles + 1; k < eNumHardwareCounters; k++)
+	{
+		AttrForCounter((HardwareCounter)k, attr);
+		mFDs[k] = OpenCounter(attr, mLeaderFD);
+		if (mFDs[k] >= 0)
+			mSlots[k] = mNumSlots++;
+		else
+			printf("hardware counters: %s unavailable (%s)\n", CounterName((HardwareCounter)k), strerror(errno));
+	}
+	
+	ioctl(mLeaderFD, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(mLeaderFD, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+void HardwareCounters::Close()
+{
+	for (int32_t k = 0; k < eNumHardwareCounters; k++)
+	{
+		if (mFDs[k] >= 0)
+			close(mFDs[k]);
+		mFDs[k] = mSlots[k] = -1;
+	}
+	
+	mLeaderFD = -1;
+	mNumSlots = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+void HardwareCounters::Read(CounterValues& values) const
+{
+	// the number of counters, the group's enabled & running times, then each
+	// value in open order
+	uint64_t buffer[3 + eNumHardwareCounters];
+	if (mLeaderFD < 0 || read(mLeaderFD, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(uint64_t)))
+	{
+		values = CounterValues();
+		return;
+	}
+	
+	values.mTimeEnabled = buffer[1];
+	values.mTimeRunning = buffer[2];
+	for (int32_t k = 0; k < eNumHardwareCounters; k++)
+		values.mCounts[k] = (mSlots[k] >= 0 && mSlots[k] < (int32_t)buffer[0]) ? buffer[3 + mSlots[k]] : 0;
+}
+
+#else
+
+/*---------------------------------------------------------------------------*/
+bool HardwareCounters::Open(String& error)
+{
+	error = "hardware counters need Linux perf_event_open";
+	return false;
+}
+
+/*---------------------------------------------------------------------------*/
+void HardwareCounters::Close()
+{
+}
+
+/*---------------------------------------------------------------------------*/
+void HardwareCounters::Read(CounterValues& values) const
+{
+	values = CounterValues();
+}
+
+#endif
+
+} // pong namespace
@@ -0,0 +1,114 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	PerfCounters.h
+	
+	Hardware performance counters (Linux perf_event_open) for the profiler -
+	cycles, instructions, L1 data & last level cache misses and branch misses,
+	read as one group so every phase sees a consistent set. The counters
+	follow the thread that opened them (the message thread, which runs the
+	whole frame) and count user space only.
+	
+	When other perf users (or a VM) leave too few hardware counters, the
+	kernel multiplexes the group - it's only on the PMU for part of the
+	time. Each reading carries how long the group was enabled & how long it
+	was actually running, so the counts are scaled up to the whole time,
+	and a phase the group never ran for is reported as not counted rather
+	than as zeros.
+	
+	Everything degrades: a counter the CPU or VM doesn't have is just
+	reported as unavailable, and if the kernel refuses the group entirely
+	(perf_event_paranoid, containers, other platforms) Open() says why and
+	the profiler carries on with timings alone.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+namespace pong
+{
+
+enum HardwareCounter
+{
+	eCounterCycles = 0,		// the group leader
+	eCounterInstructions,
+	eCounterL1DMisses,
+	eCounterLLCMisses,
+	eCounterBranchMisses,
+	eNumHardwareCounters
+};
+
+const char* CounterName(HardwareCounter counter);
+
+// CounterValues - one reading (or difference between readings) of every counter
+struct CounterValues
+{
+	uint64_t mCounts[eNumHardwareCounters] = {};	// as counted, while running
+	uint64_t mTimeEnabled = 0;	// ns
+	uint64_t mTimeRunning = 0;	// ns actually on the PMU
+	
+	CounterValues& operator+=(const CounterValues& rhs)
+	{
+		for (int32_t k = 0; k < eNumHardwareCounters; k++)
+			mCounts[k] += rhs.mCounts[k];
+		mTimeEnabled += rhs.mTimeEnabled;
+		mTimeRunning += rhs.mTimeRunning;
+		return *this;
+	}
+	
+	CounterValues operator-(const CounterValues& rhs) const
+	{
+		CounterValues diff;
+		for (int32_t k = 0; k < eNumHardwareCounters; k++)
+			diff.mCounts[k] = (mCounts[k] - rhs.mCounts[k]);
+		diff.mTimeEnabled = (mTimeEnabled - rhs.mTimeEnabled);
+		diff.mTimeRunning = (mTimeRunning - rhs.mTimeRunning);
+		return diff;
+	}
+	
+	// false if the group was never on the PMU - the counts mean nothing
+	bool IsCounted() const { return (mTimeRunning > 0); }
+	
+	// the fraction of the time the group was counting
+	double RunningFraction() const { return mTimeEnabled ? ((double)mTimeRunning / mTimeEnabled) : 0.0; }
+	
+	// counter's count, scaled up to the whole time the group was enabled
+	double Scaled(HardwareCounter counter) const
+	{
+		return this->IsCounted() ? (mCounts[counter] * ((double)mTimeEnabled / mTimeRunning)) : 0.0;
+	}
+	
+	// (all the counters are in one group, so the scaling cancels out)
+	double IPC() const
+	{
+		return (this->IsCounted() && mCounts[eCounterCycles]) ? ((double)mCounts[eCounterInstructions] / mCounts[eCounterCycles]) : 0.0;
+	}
+};
+
+// HardwareCounters
+class HardwareCounters
+{
+public:
+	HardwareCounters();
+	~HardwareCounters() { this->Close(); }
+	
+	// false (and why) if the kernel won't give us even the cycle counter
+	bool	Open(String& error);
+	void	Close();
+	
+	bool	IsOpen() const { return (mLeaderFD >= 0); }
+	bool	IsAvailable(HardwareCounter counter) const { return (mSlots[counter] >= 0); }
+	
+	// one read() of the whole group, with its enabled & running times -
+	// unavailable counters read as 0
+	void	Read(CounterValues& values) const;
+
+private:
+	int32_t	mLeaderFD;
+	int32_t	mFDs[eNumHardwareCounters];
+	int32_t	mSlots[eNumHardwareCounters]; // position in the group read, or -1
+	int32_t	mNumSlots;
+};
+
+} // pong namespace
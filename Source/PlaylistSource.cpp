@@ -0,0 +1,308 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	PlaylistSource.cpp
+*****************************************************************************/
+
+#include "PlaylistSource.h"
+#include <algorithm>
+
+/*---------------------------------------------------------------------------*/
+PlaylistSource::PlaylistSource() :
+	mSampleRate(48000),
+	mBlockSize(512)
+{
+	mCrossfadeSamples = (int64)(mCrossfadeSeconds * mSampleRate);
+	mScratch.setSize(2, mBlockSize);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	~PlaylistSource
+//   - after the audio's stopped
+/*---------------------------------------------------------------------------*/
+PlaylistSource::~PlaylistSource()
+{
+	Command c;
+	while (mCommands.Pop(c))
+		this->FreeTrack(c.mTrack);
+	
+	this->Update(nullptr);
+	this->FreeTrack(mCurrent);
+	this->FreeTrack(mNext);
+}
+
+/*---------------------------------------------------------------------------*/
+std::unique_ptr<PlaylistTrack> PlaylistSource::NewTrack(int32_t id, PositionableAudioSource* source, double sourceSampleRate,
+														int64 startPosition, double playSeconds, float gain)
+{
+	const double sampleRate = mSampleRate;
+	
+	std::unique_ptr<PlaylistTrack> track(new PlaylistTrack());
+	track->mId = id;
+	track->mSource.reset(source);
+	track->mSourceSampleRate = sourceSampleRate;
+	
+	{
+		const ScopedLock lock(mSpareLock);
+		if (!mSpareResamplers.empty())
+		{
+			track->mResampler = std::move(mSpareResamplers.back());
+			mSpareResamplers.pop_back();
+		}
+	}
+	
+	if (!track->mResampler)
+	{
+		track->mResampler.reset(new TrackResampler());
+	}
+	track->mResampler->mInput.mSource = source;
+
+	track->mGain = gain;
+	track->mPlayLength = (int64)(playSeconds * sampleRate);
+	
+	this->PrepareTrack(*track, mBlockSize, sampleRate);
+	source->setNextReadPosition(startPosition);
+	return track;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	PrepareTrack
+//   - a recycled resampler keeps its buffer if the ratio & block size come
+//     out the same as last time (it's flushed either way)
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::PrepareTrack(PlaylistTrack& track, int32_t blockSize, double sampleRate)
+{
+	track.mResample = (track.mSourceSampleRate != sampleRate);
+	track.mResampler->mResampler.setResamplingRatio(track.mSourceSampleRate / sampleRate);
+	track.mResampler->mResampler.prepareToPlay(blockSize, sampleRate);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	FreeTrack
+//   - message thread (or the audio's stopped) - keeps the resampler
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::FreeTrack(PlaylistTrack* track)
+{
+	if (!track)
+		return;
+	
+	track->mResampler->mInput.mSource = nullptr;
+	{
+		const ScopedLock lock(mSpareLock);
+		mSpareResamplers.push_back(std::move(track->mResampler));
+	}
+	delete track;
+}
+
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::Cue(std::unique_ptr<PlaylistTrack> track)
+{
+	PlaylistTrack* t = track.release();
+	if (!mCommands.Push({eCue, t, 0}))
+	{
+		printf("music: the playlist's queue is full\n");
+		this->FreeTrack(t);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::Skip()
+{
+	mCommands.Push({eSkip, nullptr, 0});
+}
+
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::SetCrossfadeSeconds(double seconds)
+{
+	mCommands.Push({eSetCrossfade, nullptr, std::max(0.0, seconds)});
+}
+
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::Update(std::function<void(int32_t id)> started)
+{
+	Event e;
+	while (mEvents.Pop(e))
+	{
+		if (e.mType == eFinished)
+			this->FreeTrack(e.mTrack);
+		else if (started)
+			started(e.mTrack->mId);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	prepareToPlay
+//   - the audio's stopped, so this can pick up the commands itself - the
+//     tracks it has are re-prepared for the new rate, and how far through
+//     them it is gets scaled to match
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+	const double scale = sampleRate / mSampleRate;
+	mSampleRate = sampleRate;
+	mBlockSize = samplesPerBlockExpected;
+	mCrossfadeSamples = (int64)(mCrossfadeSeconds * sampleRate);
+	mScratch.setSize(2, std::max(1, samplesPerBlockExpected));
+	
+	this->HandleCommands();
+	for (PlaylistTrack* track : {mCurrent, mNext})
+	{
+		if (!track)
+			continue;
+		
+		track->mPlayLength = (int64)(track->mPlayLength * scale);
+		track->mPlayed = (int64)(track->mPlayed * scale);
+		this->PrepareTrack(*track, samplesPerBlockExpected, sampleRate);
+	}
+	
+	mFadeLength = std::max((int64)1, (int64)(mFadeLength * scale));
+	mFadePos = std::min(mFadeLength, (int64)(mFadePos * scale));
+}
+
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::releaseResources()
+{
+	for (PlaylistTrack* track : {mCurrent, mNext})
+	{
+		if (track)
+			track->mResampler->mResampler.releaseResources();
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	HandleCommands
+//   - only one track waits behind the current one (the message thread cues
+//     the next once that's started), so an extra one goes straight back
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::HandleCommands()
+{
+	Command c;
+	while (mCommands.Pop(c))
+	{
+		switch (c.mType)
+		{
+			case eCue:
+				if (!mCurrent)
+				{
+					mCurrent = c.mTrack;
+					this->Start(mCurrent, mCurrent->mGain);
+				}
+				else if (!mNext)
+					mNext = c.mTrack;
+				else
+					this->Finish(c.mTrack);
+				break;
+			
+			case eSkip:
+				if (mCurrent && !mFading)
+					mCurrent->mPlayLength = std::min(mCurrent->mPlayLength, mCurrent->mPlayed + mCrossfadeSamples);
+				break;
+			
+			case eSetCrossfade:
+				mCrossfadeSeconds = c.mSeconds;
+				mCrossfadeSamples = (int64)(c.mSeconds * mSampleRate);
+				break;
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::Start(PlaylistTrack* track, float fromGain)
+{
+	track->mFader.Reset(fromGain);
+	mEvents.Push({eStarted, track});
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Finish
+//   - the message thread frees it (if the queue's full it leaks, rather than
+//     freeing it here)
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::Finish(PlaylistTrack* track)
+{
+	mEvents.Push({eFinished, track});
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Render
+//   - num samples of track into buffer, ramping its gain to gain by the end
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::Render(PlaylistTrack& track, AudioBuffer<float>& buffer, int32_t start, int32_t num, float gain)
+{
+	const AudioSourceChannelInfo info(&buffer, start, num);
+	if (track.mResample)
+		track.mResampler->mResampler.getNextAudioBlock(info);
+	else
+		track.mSource->getNextAudioBlock(info);
+	
+	track.mFader.SetTarget(gain);
+	track.mFader.Process(buffer, start, num);
+	track.mPlayed += num;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	getNextAudioBlock
+//   - the block's split wherever the crossfade starts or ends, so both
+//     happen at the exact sample. A crossfade starts so it'll end at the
+//     end of the current track's length (or right away, if the next track
+//     was cued late or it's been skipped). With nothing cued the current
+//     track just carries on.
+/*---------------------------------------------------------------------------*/
+void PlaylistSource::getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill)
+{
+	this->HandleCommands();
+	bufferToFill.clearActiveBufferRegion();
+	
+	AudioBuffer<float>& buffer = *bufferToFill.buffer;
+	const int32_t numChannels = std::min(buffer.getNumChannels(), mScratch.getNumChannels());
+	int32_t pos = 0;
+	while (pos < bufferToFill.numSamples && mCurrent)
+	{
+		const int32_t start = bufferToFill.startSample + pos;
+		int32_t num = bufferToFill.numSamples - pos;
+		
+		if (!mFading)
+		{
+			if (mNext)
+			{
+				const int64 fadeStart = std::max((int64)0, mCurrent->mPlayLength - mCrossfadeSamples);
+				const int64 untilFade = fadeStart - mCurrent->mPlayed;
+				if (untilFade <= 0)
+				{
+					const int64 remaining = mCurrent->mPlayLength - mCurrent->mPlayed;
+					mFadeLength = std::max((int64)1, (remaining > 0) ? std::min(mCrossfadeSamples, remaining) : mCrossfadeSamples);
+					mFadePos = 0;
+					mFading = true;
+					this->Start(mNext, 0.0f);
+					continue;
+				}
+				
+				num = (int32_t)std::min((int64)num, untilFade);
+			}
+			
+			this->Render(*mCurrent, buffer, start, num, mCurrent->mGain);
+		}
+		else
+		{
+			num = (int32_t)std::min({(int64)num, mFadeLength - mFadePos, (int64)mScratch.getNumSamples()});
+			mFadePos += num;
+			
+			const float in = (float)mFadePos / mFadeLength;
+			this->Render(*mCurrent, buffer, start, num, mCurrent->mGain * (1.0f - in));
+			this->Render(*mNext, mScratch, 0, num, mNext->mGain * in);
+			for (int32_t c = 0; c < numChannels; c++)
+				FloatVectorOperations::add(buffer.getWritePointer(c, start), mScratch.getReadPointer(c), num);
+			
+			if (mFadePos >= mFadeLength)
+			{
+				this->Finish(mCurrent);
+				mCurrent = mNext;
+				mNext = nullptr;
+				mFading = false;
+			}
+		}
+		
+		pos += num;
+	}
+}
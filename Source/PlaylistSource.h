@@ -0,0 +1,186 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	PlaylistSource.h
+	
+	Plays the music as one gapless stream. Songs are opened & pre-rolled off
+	the audio thread and then cued - handed over to the audio thread,
+	which plays each one for its length and then crossfades into the next
+	starting at that exact sample (so a song change never waits for a timer
+	or stops the audio callback).
+	
+	The two threads only talk through lock-free queues: commands (cue a
+	track, skip, set the crossfade) go to the audio thread, and what's
+	happened (a track started, a track's finished with) comes back - so the
+	message thread frees the finished tracks, not the audio thread. The
+	message thread picks those up in Update().
+	
+	Each track is resampled to the rate the device reports (unless it's
+	already at that rate) and has its own gain, which the crossfade ramps
+	(see SmoothedGain). The resamplers are recycled from one track to the
+	next rather than allocated for each one.
+	
+	This lives in the global namespace (like IPongView) so MainComponent,
+	which has its own 'pong', can use it.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SmoothedGain.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// LockFreeQueue - one thread pushes, another pops
+template<class T, int32_t kSize>
+class LockFreeQueue
+{
+public:
+	LockFreeQueue() : mFifo(kSize) {}
+	
+	// false if it's full
+	bool Push(const T& item)
+	{
+		int32_t start1, size1, start2, size2;
+		mFifo.prepareToWrite(1, start1, size1, start2, size2);
+		if ((size1 + size2) == 0)
+			return false;
+		
+		mItems[(size1 > 0) ? start1 : start2] = item;
+		mFifo.finishedWrite(1);
+		return true;
+	}
+	
+	// false if it's empty
+	bool Pop(T& item)
+	{
+		int32_t start1, size1, start2, size2;
+		mFifo.prepareToRead(1, start1, size1, start2, size2);
+		if ((size1 + size2) == 0)
+			return false;
+		
+		item = mItems[(size1 > 0) ? start1 : start2];
+		mFifo.finishedRead(1);
+		return true;
+	}
+
+private:
+	AbstractFifo	mFifo;
+	T				mItems[kSize];
+};
+
+// TrackResampler - resamples whichever track's source mInput is pointed at
+struct TrackResampler
+{
+	struct Input : public AudioSource
+	{
+		void	prepareToPlay(int samplesPerBlockExpected, double sampleRate) override { mSource->prepareToPlay(samplesPerBlockExpected, sampleRate); }
+		void	releaseResources() override { mSource->releaseResources(); }
+		void	getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill) override { mSource->getNextAudioBlock(bufferToFill); }
+		
+		AudioSource* mSource = nullptr;
+	};
+	
+	TrackResampler() : mResampler(&mInput, false) {}
+	
+	Input					mInput;
+	ResamplingAudioSource	mResampler;
+};
+
+// PlaylistTrack - a song, ready to play (see PlaylistSource::NewTrack)
+struct PlaylistTrack
+{
+	int32_t		mId;
+	std::unique_ptr<PositionableAudioSource> mSource;
+	std::unique_ptr<TrackResampler> mResampler; // reads mSource
+	double		mSourceSampleRate;
+	bool		mResample = false; // or mSource is at the device rate
+	float		mGain;
+	
+	// in device samples - the next track's crossfade ends at mPlayLength
+	int64		mPlayLength;
+	int64		mPlayed = 0;
+	SmoothedGain mFader;	// mGain, ramped by the crossfades
+};
+
+// PlaylistSource
+class PlaylistSource : public AudioSource
+{
+public:
+	static const int32_t kQueueSize = 64;
+	static constexpr double kDefaultCrossfadeSeconds = 2.0;
+	
+	PlaylistSource();
+	~PlaylistSource();
+	
+	// any thread but the audio thread (pre-rolling source can take a while,
+	// so it needn't be the message thread) - a track that plays source from
+	// startPosition (in its own samples) for playSeconds, resampled to the
+	// device rate & already reading ahead
+	std::unique_ptr<PlaylistTrack> NewTrack(int32_t id, PositionableAudioSource* source, double sourceSampleRate,
+											int64 startPosition, double playSeconds, float gain);
+	
+	// message thread - plays track after the ones already cued (or right
+	// away if nothing's playing)
+	void	Cue(std::unique_ptr<PlaylistTrack> track);
+	
+	// message thread - starts the crossfade into the next track now
+	void	Skip();
+	void	SetCrossfadeSeconds(double seconds);
+	
+	// message thread - frees the tracks the audio thread's finished with,
+	// and calls started(id) for each track that's started since last time
+	void	Update(std::function<void(int32_t id)> started);
+	
+	// AudioSource
+	void	prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+	void	releaseResources() override;
+	void	getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill) override;
+
+private:
+	enum CommandType { eCue, eSkip, eSetCrossfade };
+	struct Command
+	{
+		CommandType		mType;
+		PlaylistTrack*	mTrack;
+		double			mSeconds;
+	};
+	
+	enum EventType { eStarted, eFinished };
+	struct Event
+	{
+		EventType		mType;
+		PlaylistTrack*	mTrack;
+	};
+	
+	void	PrepareTrack(PlaylistTrack& track, int32_t blockSize, double sampleRate);
+	void	FreeTrack(PlaylistTrack* track);
+	
+	// audio thread
+	void	HandleCommands();
+	void	Start(PlaylistTrack* track, float fromGain);
+	void	Finish(PlaylistTrack* track);
+	void	Render(PlaylistTrack& track, AudioBuffer<float>& buffer, int32_t start, int32_t num, float gain);
+	
+	std::atomic<double>		mSampleRate;
+	std::atomic<int32_t>	mBlockSize;
+	
+	LockFreeQueue<Command, kQueueSize> mCommands;	// to the audio thread
+	LockFreeQueue<Event, kQueueSize> mEvents;		// from the audio thread
+	
+	// the audio thread's (or anyone's while the audio's stopped)
+	PlaylistTrack*		mCurrent = nullptr;
+	PlaylistTrack*		mNext = nullptr;
+	int64				mCrossfadeSamples = 0;
+	double				mCrossfadeSeconds = kDefaultCrossfadeSeconds;
+	bool				mFading = false;
+	int64				mFadeLength = 0;
+	int64				mFadePos = 0;
+	AudioBuffer<float>	mScratch; // the next track, while it fades in
+	
+	// from tracks that have been freed - NewTrack can run on another thread
+	CriticalSection		mSpareLock;
+	std::vector<std::unique_ptr<TrackResampler>> mSpareResamplers; // mSpareLock
+};
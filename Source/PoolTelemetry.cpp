@@ -0,0 +1,161 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	PoolTelemetry.cpp
+*****************************************************************************/
+
+#include "PoolTelemetry.h"
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+const char* ObjectTypeName(int32_t typeIndex)
+{
+	static const char* kNames[kNumObjectTypes] =
+	{
+		"ship", "bullet", "fragment", "shipFragment", "icon", "vector", "chaser",
+		"ground", "flatEarth", "gravity", "miniMap", "hostage", "textBubble"
+	};
+	
+	return (typeIndex >= 0 && typeIndex < kNumObjectTypes) ? kNames[typeIndex] : "";
+}
+
+/*---------------------------------------------------------------------------*/
+void PoolTelemetry::Reset(int32_t capacity)
+{
+	mCapacity = capacity;
+	for (int32_t k = 0; k < kNumObjectTypes; k++)
+		mTypes[k] = TypeStats();
+	mTotal = TypeStats();
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	AllocationFailed
+//   - the pool is full - count it, and say so the first time
+/*---------------------------------------------------------------------------*/
+void PoolTelemetry::AllocationFailed(int32_t typeIndex)
+{
+	if (!mTotal.mNumFailed)
+		printf("object pool: out of slots (first failure was a %s)\n", ObjectTypeName(typeIndex));
+	
+	mTypes[typeIndex].mNumFailed++;
+	mTotal.mNumFailed++;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DrawOverlay
+//   - an occupancy bar (live & high-water) over a table of the types seen
+/*---------------------------------------------------------------------------*/
+void PoolTelemetry::DrawOverlay(Graphics& g, const Rectangle<int>& bounds) const
+{
+	static const int32_t kRowHeight = 14;
+	static const int32_t kMargin = 6;
+	static const int32_t kColumnX[] = {0, 90, 140, 190, 250, 300, 350};
+	static const int32_t kColumnWidth = 50;
+	
+	g.setColour(Colours::black.withAlpha(0.75f));
+	g.fillRect(bounds);
+	
+	Rectangle<int> area = bounds.reduced(kMargin);
+	
+	// occupancy bar
+	const Rectangle<int> bar = area.removeFromTop(10);
+	const float scale = (float)bar.getWidth() / std::max(1, mCapacity);
+	g.setColour(Colours::darkgrey);
+	g.fillRect(bar);
+	g.setColour(mTotal.mNumFailed ? Colours::red : Colours::limegreen);
+	g.fillRect((float)bar.getX(), (float)bar.getY(), mTotal.mLive * scale, (float)bar.getHeight());
+	g.setColour(Colours::yellow);
+	g.drawVerticalLine(bar.getX() + (int32_t)(mTotal.mHighWater * scale), (float)bar.getY(), (float)bar.getBottom());
+	area.removeFromTop(kMargin);
+	
+	g.setFont(12.0f);
+	int32_t y = area.getY();
+	auto drawRow = [&](const String cells[7])
+	{
+		for (int32_t c = 0; c < 7; c++)
+		{
+			g.drawText(cells[c], area.getX() + kColumnX[c], y, (c == 0 ? 90 : kColumnWidth), kRowHeight,
+					   (c == 0 ? Justification::left : Justification::right), false);
+		}
+		y += kRowHeight;
+	};
+	
+	g.setColour(Colours::honeydew);
+	const String header[7] = {"type", "live", "high", "allocs", "failed", "life50", "life99"};
+	drawRow(header);
+	
+	for (int32_t k = 0; k < kNumObjectTypes; k++)
+	{
+		const TypeStats& s = mTypes[k];
+		if (!s.mNumAllocs && !s.mNumFailed)
+			continue;
+		
+		const String row[7] =
+		{
+			ObjectTypeName(k), String(s.mLive), String(s.mHighWater), String((int64)s.mNumAllocs),
+			String((int64)s.mNumFailed), String(s.mLifetimes.GetPercentileMS(50) / 1000.0, 1) + "s",
+			String(s.mLifetimes.GetPercentileMS(99) / 1000.0, 1) + "s"
+		};
+		g.setColour(s.mNumFailed ? Colours::orangered : Colours::honeydew);
+		drawRow(row);
+	}
+	
+	const String total[7] =
+	{
+		"all / " + String(mCapacity), String(mTotal.mLive), String(mTotal.mHighWater),
+		String((int64)mTotal.mNumAllocs), String((int64)mTotal.mNumFailed), "", ""
+	};
+	g.setColour(Colours::yellow);
+	drawRow(total);
+}
+
+/*---------------------------------------------------------------------------*/
+void PoolTelemetry::Print() const
+{
+	printf("  pool: high-water %d of %d, %lld allocs, %lld frees, %lld failed\n", mTotal.mHighWater, mCapacity,
+		   (long long)mTotal.mNumAllocs, (long long)mTotal.mNumFrees, (long long)mTotal.mNumFailed);
+	
+	for (int32_t k = 0; k < kNumObjectTypes; k++)
+	{
+		const TypeStats& s = mTypes[k];
+		if (!s.mNumAllocs && !s.mNumFailed)
+			continue;
+		
+		printf("    %-14s live %4d  high %4d  allocs %7lld  failed %5lld  life p50 %8.0f ms  p99 %8.0f ms\n",
+			   ObjectTypeName(k), s.mLive, s.mHighWater, (long long)s.mNumAllocs, (long long)s.mNumFailed,
+			   s.mLifetimes.GetPercentileMS(50), s.mLifetimes.GetPercentileMS(99));
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+bool PoolTelemetry::WriteCSV(const File& file) const
+{
+	file.deleteFile();
+	FileOutputStream out(file);
+	if (out.failedToOpen())
+		return false;
+	
+	auto writeRow = [&out](const String& name, const TypeStats& s, bool lifetimes)
+	{
+		out << name << "," << String((int64)s.mNumAllocs) << "," << String((int64)s.mNumFrees) << ","
+			<< String((int64)s.mNumFailed) << "," << String(s.mLive) << "," << String(s.mHighWater);
+		if (lifetimes)
+		{
+			out << "," << String(s.mLifetimes.GetMeanMS(), 1) << "," << String(s.mLifetimes.GetPercentileMS(50), 1)
+				<< "," << String(s.mLifetimes.GetPercentileMS(99), 1) << "," << String(s.mLifetimes.GetMaxMS(), 1);
+		}
+		out << "\n";
+	};
+	
+	out << "type,allocs,frees,failed,live,high_water,life_mean_ms,life_p50_ms,life_p99_ms,life_max_ms\n";
+	writeRow("all/" + String(mCapacity), mTotal, false);
+	for (int32_t k = 0; k < kNumObjectTypes; k++)
+		writeRow(ObjectTypeName(k), mTypes[k], true);
+	
+	return true;
+}
+
+} // pong namespace
@@ -0,0 +1,98 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	PoolTelemetry.h
+	
+	Occupancy & churn counters for CObjectPool - allocations, frees, failed
+	allocations, live objects & high-water marks per EObjectType, and how
+	long each type lives (in game time). Counting is a few increments per
+	NewObject/FreeObject, so it's always on.
+	
+	'O' in the game shows the overlay, the numbers are printed after
+	headless runs, and with --pool-csv path (or --profile / --stress, which
+	leave SpaceForcePool.csv on the desktop) the windowed game writes them
+	out on exit - enough to size the pool from real sessions.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Profiler.h"
+
+class IPongView;
+
+namespace pong
+{
+
+const int32_t kNumObjectTypes = 13; // one per EObjectType bit, eShip .. eTextBubble
+
+const char*	ObjectTypeName(int32_t typeIndex);
+
+// ObjectTypeIndex - EObjectType bit to 0 .. kNumObjectTypes-1
+inline int32_t ObjectTypeIndex(int32_t type)
+{
+	for (int32_t k = 0; k < kNumObjectTypes; k++)
+	{
+		if (type == (1 << k))
+			return k;
+	}
+	return 0;
+}
+
+// PoolTelemetry
+class PoolTelemetry
+{
+public:
+	struct TypeStats
+	{
+		int64_t		mNumAllocs = 0;
+		int64_t		mNumFrees = 0;
+		int64_t		mNumFailed = 0;
+		int32_t		mLive = 0;
+		int32_t		mHighWater = 0;
+		Histogram	mLifetimes; // game time, from NewObject to FreeObject
+	};
+	
+	PoolTelemetry() { this->Reset(0); }
+	
+	void	Reset(int32_t capacity);
+	int32_t	GetCapacity() const { return mCapacity; }
+	
+	void	Allocated(int32_t typeIndex)
+	{
+		TypeStats& s = mTypes[typeIndex];
+		s.mNumAllocs++;
+		s.mHighWater = std::max(s.mHighWater, ++s.mLive);
+		mTotal.mNumAllocs++;
+		mTotal.mHighWater = std::max(mTotal.mHighWater, ++mTotal.mLive);
+	}
+	
+	void	Freed(int32_t typeIndex, int64_t lifetimeMS)
+	{
+		TypeStats& s = mTypes[typeIndex];
+		s.mNumFrees++;
+		s.mLive--;
+		s.mLifetimes.AddMS((double)lifetimeMS);
+		mTotal.mNumFrees++;
+		mTotal.mLive--;
+	}
+	
+	void	AllocationFailed(int32_t typeIndex);
+	
+	const TypeStats& GetTypeStats(int32_t typeIndex) const { return mTypes[typeIndex]; }
+	const TypeStats& GetTotalStats() const { return mTotal; } // no lifetimes
+	
+	void	DrawOverlay(Graphics& g, const Rectangle<int>& bounds) const;
+	void	Print() const;
+	bool	WriteCSV(const File& file) const;
+
+private:
+	int32_t		mCapacity;
+	TypeStats	mTypes[kNumObjectTypes];
+	TypeStats	mTotal;
+};
+
+// the telemetry of a view's object pool (defined in SpaceForce.cpp, next to CObjectPool)
+const PoolTelemetry& PoolTelemetryFor(IPongView& view);
+
+} // pong namespace
@@ -0,0 +1,387 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	Profiler.cpp
+*****************************************************************************/
+
+#include "Profiler.h"
+
+namespace pong
+{
+
+Profiler gProfiler;
+
+namespace
+{
+	// graph colors, by phase
+	const Colour kPhaseColors[eNumProfilePhases] =
+	{
+		Colours::grey,			// input
+		Colours::mediumpurple,	// updateLevel
+		Colours::dodgerblue,	// animate
+		Colours::cyan,			// gravity
+		Colours::orange,		// interactions
+		Colours::yellow,		// verticalBounds
+		Colours::limegreen,		// draw
+		Colours::pink,			// text
+		Colours::tomato			// distanceGame
+	};
+}
+
+/*---------------------------------------------------------------------------*/
+const char* PhaseName(ProfilePhase phase)
+{
+	switch (phase)
+	{
+		case ePhaseInput:			return "input";
+		case ePhaseUpdateLevel:		return "updateLevel";
+		case ePhaseAnimate:			return "animate";
+		case ePhaseGravity:			return "gravity";
+		case ePhaseInteractions:	return "interactions";
+		case ePhaseVerticalBounds:	return "verticalBounds";
+		case ePhaseDraw:			return "draw";
+		case ePhaseText:			return "text";
+		case ePhaseDistanceGame:	return "distanceGame";
+		default:					return "";
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+double TicksToMS(int64_t ticks)
+{
+	return Time::highResolutionTicksToSeconds(ticks) * 1000.0;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	BucketForMicros
+/*---------------------------------------------------------------------------*/
+int32_t Histogram::BucketForMicros(double us)
+{
+	if (us < kNumLinear)
+		return std::max(0, (int32_t)us);
+	
+	// which octave above kNumLinear, then which of the kNumLinear steps within it
+	int32_t exponent = 0;
+	const double mantissa = std::frexp(us / kNumLinear, &exponent); // [0.5, 1)
+	const int32_t octave = (exponent - 1);
+	if (octave >= kNumOctaves)
+		return (kNumBuckets - 1);
+	
+	const int32_t step = std::min(kNumLinear - 1, (int32_t)((mantissa * 2 - 1) * kNumLinear));
+	return kNumLinear + (octave * kNumLinear) + step;
+}
+
+/*---------------------------------------------------------------------------*/
+double Histogram::UpperMicrosForBucket(int32_t bucket)
+{
+	if (bucket < kNumLinear)
+		return (bucket + 1);
+	
+	const int32_t octave = (bucket - kNumLinear) / kNumLinear;
+	const int32_t step = (bucket - kNumLinear) % kNumLinear;
+	return std::ldexp((double)kNumLinear, octave) * (1.0 + (step + 1) / (double)kNumLinear);
+}
+
+/*---------------------------------------------------------------------------*/
+void Histogram::Reset()
+{
+	std::fill(mBuckets, mBuckets + kNumBuckets, 0);
+	mCount = 0;
+	mTotalTicks = 0;
+	mMaxTicks = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+void Histogram::Add(int64_t ticks)
+{
+	mBuckets[BucketForMicros(TicksToMS(ticks) * 1000.0)]++;
+	mCount++;
+	mTotalTicks += ticks;
+	mMaxTicks = std::max(mMaxTicks, ticks);
+}
+
+/*---------------------------------------------------------------------------*/
+double Histogram::GetMeanMS() const
+{
+	return mCount ? (TicksToMS(mTotalTicks) / mCount) : 0.0;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	GetPercentileMS
+//   - the upper edge of the bucket holding the percentile, capped at the max
+/*---------------------------------------------------------------------------*/
+double Histogram::GetPercentileMS(double percentile) const
+{
+	if (!mCount)
+		return 0.0;
+	
+	const int64_t target = std::max<int64_t>(1, (int64_t)std::ceil(percentile / 100.0 * mCount));
+	
+	int64_t seen = 0;
+	for (int32_t k = 0; k < kNumBuckets; k++)
+	{
+		seen += mBuckets[k];
+		if (seen >= target)
+			return std::min(this->GetMaxMS(), UpperMicrosForBucket(k) / 1000.0);
+	}
+	
+	return this->GetMaxMS();
+}
+
+/*---------------------------------------------------------------------------*/
+void Profiler::SetEnabled(bool enabled)
+{
+	mEnabled = enabled;
+	
+	// don't let a frame that straddles the switch count
+	mFrameStartTicks = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	EnableHardwareCounters
+/*---------------------------------------------------------------------------*/
+bool Profiler::EnableHardwareCounters()
+{
+	String error;
+	if (!mCounters.Open(error))
+	{
+		printf("hardware counters disabled - %s\n", error.toRawUTF8());
+		return false;
+	}
+	
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+		mPhaseCounters[k] = CounterValues();
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+void Profiler::Reset()
+{
+	mNumFrames = 0;
+	mFrameStartTicks = 0;
+	mTotalFrameTicks = 0;
+	mMaxFrameTicks = 0;
+	mLastFrameTicks = 0;
+	
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+	{
+		mPhaseTicks[k] = mFramePhaseTicks[k] = mLastPhaseTicks[k] = 0;
+		mPhaseHistograms[k].Reset();
+		mPhaseCounters[k] = CounterValues();
+	}
+	
+	mFrameHistogram.Reset();
+	
+	mGraphIndex = 0;
+	for (int32_t f = 0; f < kNumGraphFrames; f++)
+	{
+		mGraphFrameMS[f] = 0;
+		std::fill(mGraphPhaseMS[f], mGraphPhaseMS[f] + eNumProfilePhases, 0.0f);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void Profiler::BeginFrame()
+{
+	if (!mEnabled)
+		return;
+	
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+		mFramePhaseTicks[k] = 0;
+	
+	mFrameStartTicks = Time::getHighResolutionTicks();
+}
+
+/*---------------------------------------------------------------------------*/
+void Profiler::EndFrame()
+{
+	if (!mEnabled || !mFrameStartTicks)
+		return;
+	
+	const int64_t frameTicks = (Time::getHighResolutionTicks() - mFrameStartTicks);
+	mTotalFrameTicks += frameTicks;
+	mMaxFrameTicks = std::max(mMaxFrameTicks, frameTicks);
+	mLastFrameTicks = frameTicks;
+	mNumFrames++;
+	mFrameHistogram.Add(frameTicks);
+	
+	mGraphIndex = ((mGraphIndex + 1) % kNumGraphFrames);
+	mGraphFrameMS[mGraphIndex] = (float)TicksToMS(frameTicks);
+	
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+	{
+		mPhaseTicks[k] += mFramePhaseTicks[k];
+		mLastPhaseTicks[k] = mFramePhaseTicks[k];
+		mPhaseHistograms[k].Add(mFramePhaseTicks[k]);
+		mGraphPhaseMS[mGraphIndex][k] = (float)TicksToMS(mFramePhaseTicks[k]);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+double Profiler::GetTotalFrameMS() const
+{
+	return TicksToMS(mTotalFrameTicks);
+}
+
+/*---------------------------------------------------------------------------*/
+double Profiler::GetMaxFrameMS() const
+{
+	return TicksToMS(mMaxFrameTicks);
+}
+
+/*---------------------------------------------------------------------------*/
+double Profiler::GetTotalPhaseMS(ProfilePhase phase) const
+{
+	return TicksToMS(mPhaseTicks[phase]);
+}
+
+/*---------------------------------------------------------------------------*/
+double Profiler::GetLastFrameMS() const
+{
+	return TicksToMS(mLastFrameTicks);
+}
+
+/*---------------------------------------------------------------------------*/
+double Profiler::GetLastPhaseMS(ProfilePhase phase) const
+{
+	return TicksToMS(mLastPhaseTicks[phase]);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DrawOverlay
+//   - each recent frame is a bar stacked by phase, against a line at the budget
+/*---------------------------------------------------------------------------*/
+void Profiler::DrawOverlay(Graphics& g, const Rectangle<int>& bounds, double budgetMS) const
+{
+	static const int32_t kRowHeight = 14;
+	static const int32_t kMargin = 6;
+	
+	g.setColour(Colours::black.withAlpha(0.75f));
+	g.fillRect(bounds);
+	
+	const int32_t tableHeight = (kRowHeight * (eNumProfilePhases + 2));
+	Rectangle<int> area = bounds.reduced(kMargin);
+	const Rectangle<int> table = area.removeFromBottom(tableHeight);
+	const Rectangle<int> graph = area.withTrimmedBottom(kMargin);
+	
+	// the graph is scaled to twice the budget, so the budget line is half way up
+	const float msToPixels = (float)(graph.getHeight() / (2.0 * budgetMS));
+	const float barWidth = (float)graph.getWidth() / kNumGraphFrames;
+	
+	for (int32_t f = 1; f <= kNumGraphFrames; f++)
+	{
+		// oldest on the left
+		const int32_t index = ((mGraphIndex + f) % kNumGraphFrames);
+		const float x = graph.getX() + ((f - 1) * barWidth);
+		float y = (float)graph.getBottom();
+		
+		for (int32_t k = 0; k < eNumProfilePhases && y > graph.getY(); k++)
+		{
+			const float h = std::min(y - graph.getY(), mGraphPhaseMS[index][k] * msToPixels);
+			if (h <= 0)
+				continue;
+			
+			y -= h;
+			g.setColour(kPhaseColors[k]);
+			g.fillRect(x, y, barWidth, h);
+		}
+		
+		// whatever the phases don't cover (overlay, intro screens, etc.)
+		const float total = std::min((float)graph.getHeight(), mGraphFrameMS[index] * msToPixels);
+		const float top = (graph.getBottom() - total);
+		if (top < y)
+		{
+			g.setColour(Colours::darkgrey);
+			g.fillRect(x, top, barWidth, y - top);
+		}
+	}
+	
+	g.setColour(Colours::red);
+	g.drawHorizontalLine(graph.getBottom() - (int32_t)(budgetMS * msToPixels), (float)graph.getX(), (float)graph.getRight());
+	
+	// table
+	g.setFont(12.0f);
+	int32_t y = table.getY();
+	const bool counters = mCounters.IsOpen();
+	auto drawRow = [&](const String& name, const Histogram& h, Colour c, const CounterValues* v)
+	{
+		g.setColour(c);
+		g.fillRect(table.getX(), y + 3, 8, 8);
+		g.setColour(Colours::honeydew);
+		g.drawText(name, table.getX() + 12, y, 110, kRowHeight, Justification::left, false);
+		g.drawText(String(h.GetPercentileMS(50), 3), table.getX() + 120, y, 70, kRowHeight, Justification::right, false);
+		g.drawText(String(h.GetPercentileMS(99), 3), table.getX() + 190, y, 70, kRowHeight, Justification::right, false);
+		g.drawText(String(h.GetMaxMS(), 3), table.getX() + 260, y, 70, kRowHeight, Justification::right, false);
+		if (counters && v)
+			g.drawText(v->IsCounted() ? String(v->IPC(), 2) : String("-"), table.getX() + 330, y, 50, kRowHeight, Justification::right, false);
+		y += kRowHeight;
+	};
+	
+	g.setColour(Colours::honeydew);
+	g.drawText("ms", table.getX() + 12, y, 110, kRowHeight, Justification::left, false);
+	g.drawText("p50", table.getX() + 120, y, 70, kRowHeight, Justification::right, false);
+	g.drawText("p99", table.getX() + 190, y, 70, kRowHeight, Justification::right, false);
+	g.drawText("max", table.getX() + 260, y, 70, kRowHeight, Justification::right, false);
+	if (counters)
+		g.drawText("ipc", table.getX() + 330, y, 50, kRowHeight, Justification::right, false);
+	y += kRowHeight;
+	
+	drawRow("frame", mFrameHistogram, Colours::darkgrey, nullptr);
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+		drawRow(PhaseName((ProfilePhase)k), mPhaseHistograms[k], kPhaseColors[k], &mPhaseCounters[k]);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	WriteCSV
+/*---------------------------------------------------------------------------*/
+bool Profiler::WriteCSV(const File& file) const
+{
+	file.deleteFile();
+	FileOutputStream out(file);
+	if (out.failedToOpen())
+		return false;
+	
+	const bool counters = mCounters.IsOpen();
+	
+	// the frame row leaves the counter columns empty - they're per phase, and
+	// scaled for the time the group was multiplexed off the PMU (a phase it
+	// never ran for is left empty too)
+	auto writeRow = [&](const String& name, const Histogram& h, const CounterValues* v)
+	{
+		out << name << "," << String((int64)h.GetCount()) << "," << String(h.GetMeanMS(), 4) << ","
+			<< String(h.GetPercentileMS(50), 4) << "," << String(h.GetPercentileMS(99), 4) << ","
+			<< String(h.GetMaxMS(), 4);
+		
+		if (counters)
+		{
+			const bool counted = (v && v->IsCounted());
+			out << "," << (counted ? String(v->IPC(), 3) : String());
+			out << "," << (counted ? String(v->RunningFraction() * 100.0, 1) : String());
+			for (int32_t c = 0; c < eNumHardwareCounters; c++)
+			{
+				out << ",";
+				if (counted && mNumFrames && mCounters.IsAvailable((HardwareCounter)c))
+					out << String(v->Scaled((HardwareCounter)c) / mNumFrames, 1);
+			}
+		}
+		out << "\n";
+	};
+	
+	out << "phase,count,mean_ms,p50_ms,p99_ms,max_ms";
+	if (counters)
+	{
+		out << ",ipc,counted_pct";
+		for (int32_t c = 0; c < eNumHardwareCounters; c++)
+			out << "," << CounterName((HardwareCounter)c) << "_per_frame";
+	}
+	out << "\n";
+	
+	writeRow("frame", mFrameHistogram, nullptr);
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+		writeRow(PhaseName((ProfilePhase)k), mPhaseHistograms[k], &mPhaseCounters[k]);
+	
+	return true;
+}
+
+} // pong namespace
@@ -0,0 +1,182 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	Profiler.h
+	
+	Per-phase frame timing. Each phase of a TPongView frame is wrapped in an
+	StPhaseTimer, which accumulates high resolution ticks into gProfiler
+	(and records the phase on the trace timeline, see Trace.h).
+	
+	With hardware counters on (--counters, Linux only) each phase also
+	accumulates cycles, instructions & misses. Reading the counter group is a
+	syscall at each end of every phase, so the timings grow a little.
+	
+	The profiler is off by default in the windowed game (though the flight
+	recorder turns it on for the frame times) - 'F' (or --profile) turns it
+	on along with the overlay graph, and only then is the summary written to
+	SpaceForceProfile.csv on the desktop on exit. While it's off, a timer is
+	a single branch.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+
+namespace pong
+{
+
+// ProfilePhase - the phases of one frame, in the order they run
+enum ProfilePhase
+{
+	ePhaseInput = 0,		// CheckKeyPresses
+	ePhaseUpdateLevel,		// UpdateLevel & CreateNewObjects
+	ePhaseAnimate,			// CObjectPool::Animate & ParticleSystem::Animate
+	ePhaseGravity,			// CObjectPool::ResetGravityAcc
+	ePhaseInteractions,		// CObjectPool::HandleObjectPairInteractions
+	ePhaseVerticalBounds,	// CObjectPool::CheckVerticalBounds
+	ePhaseDraw,				// CObjectPool::Draw & ParticleSystem::Draw
+	ePhaseText,				// DrawText
+	ePhaseDistanceGame,		// DoDistanceGame
+	eNumProfilePhases
+};
+
+const char*	PhaseName(ProfilePhase phase);
+double		TicksToMS(int64_t ticks);
+
+// Histogram - fixed memory log-linear histogram of times, 1us up to ~30 sec
+//  - 1us buckets below 16us, then 16 buckets per octave (~6% resolution)
+class Histogram
+{
+public:
+	Histogram() { this->Reset(); }
+	
+	void		Reset();
+	void		Add(int64_t ticks);
+	void		AddMS(double ms) { this->Add(Time::secondsToHighResolutionTicks(ms / 1000.0)); }
+	
+	int64_t		GetCount() const { return mCount; }
+	double		GetMeanMS() const;
+	double		GetMaxMS() const { return TicksToMS(mMaxTicks); }
+	double		GetPercentileMS(double percentile) const;
+	
+private:
+	static const int32_t kNumLinear = 16;
+	static const int32_t kNumOctaves = 21;
+	static const int32_t kNumBuckets = kNumLinear + (kNumOctaves * kNumLinear);
+	
+	static int32_t	BucketForMicros(double us);
+	static double	UpperMicrosForBucket(int32_t bucket);
+	
+	uint32_t	mBuckets[kNumBuckets];
+	int64_t		mCount;
+	int64_t		mTotalTicks;
+	int64_t		mMaxTicks;
+};
+
+// Profiler
+class Profiler
+{
+public:
+	Profiler() : mEnabled(false) { this->Reset(); }
+	
+	bool		IsEnabled() const { return mEnabled; }
+	void		SetEnabled(bool enabled);
+	
+	// counts for the calling thread from now on - false if the kernel says no
+	bool		EnableHardwareCounters();
+	bool		CountersEnabled() const { return (mEnabled && mCounters.IsOpen()); }
+	const HardwareCounters& GetHardwareCounters() const { return mCounters; }
+	void		ReadCounters(CounterValues& values) const { mCounters.Read(values); }
+	void		AddPhaseCounters(ProfilePhase phase, const CounterValues& values) { mPhaseCounters[phase] += values; }
+	const CounterValues& GetTotalPhaseCounters(ProfilePhase phase) const { return mPhaseCounters[phase]; }
+	
+	void		Reset();
+	void		BeginFrame();
+	void		EndFrame();
+	void		AddPhaseTicks(ProfilePhase phase, int64_t ticks) { mFramePhaseTicks[phase] += ticks; }
+	
+	int64_t		GetNumFrames() const { return mNumFrames; }
+	double		GetTotalFrameMS() const;
+	double		GetMaxFrameMS() const;
+	double		GetTotalPhaseMS(ProfilePhase phase) const;
+	
+	// the most recently completed frame
+	double		GetLastFrameMS() const;
+	double		GetLastPhaseMS(ProfilePhase phase) const;
+	
+	const Histogram& GetFrameHistogram() const { return mFrameHistogram; }
+	const Histogram& GetPhaseHistogram(ProfilePhase phase) const { return mPhaseHistograms[phase]; }
+	
+	// graph of the recent frames (stacked by phase) plus the p50/p99/max table
+	void		DrawOverlay(Graphics& g, const Rectangle<int>& bounds, double budgetMS) const;
+	
+	// one line per phase - count, mean, p50, p99, max (and counters per frame)
+	bool		WriteCSV(const File& file) const;
+	
+private:
+	static const int32_t kNumGraphFrames = 240;
+	
+	bool		mEnabled;
+	int64_t		mNumFrames;
+	int64_t		mFrameStartTicks;
+	int64_t		mTotalFrameTicks;
+	int64_t		mMaxFrameTicks;
+	int64_t		mLastFrameTicks;
+	int64_t		mPhaseTicks[eNumProfilePhases];
+	int64_t		mFramePhaseTicks[eNumProfilePhases];
+	int64_t		mLastPhaseTicks[eNumProfilePhases];
+	
+	HardwareCounters mCounters;
+	CounterValues mPhaseCounters[eNumProfilePhases];
+	
+	Histogram	mFrameHistogram;
+	Histogram	mPhaseHistograms[eNumProfilePhases];
+	
+	// ring of the recent frames for the overlay graph
+	int32_t		mGraphIndex;
+	float		mGraphFrameMS[kNumGraphFrames];
+	float		mGraphPhaseMS[kNumGraphFrames][eNumProfilePhases];
+};
+
+extern Profiler gProfiler;
+
+/*---------------------------------------------------------------------------*/
+// StPhaseTimer - times the enclosing scope (when profiling or tracing)
+class StPhaseTimer
+{
+public:
+	StPhaseTimer(ProfilePhase phase) :
+		mPhase(phase),
+		mStartTicks((gProfiler.IsEnabled() || gTraceRecorder.IsEnabled()) ? Time::getHighResolutionTicks() : 0)
+	{
+		if (gProfiler.CountersEnabled())
+			gProfiler.ReadCounters(mStartCounts);
+	}
+	~StPhaseTimer()
+	{
+		if (!mStartTicks)
+			return;
+		
+		if (gProfiler.CountersEnabled())
+		{
+			CounterValues endCounts;
+			gProfiler.ReadCounters(endCounts);
+			gProfiler.AddPhaseCounters(mPhase, endCounts - mStartCounts);
+		}
+		
+		const int64_t ticks = (Time::getHighResolutionTicks() - mStartTicks);
+		if (gProfiler.IsEnabled())
+			gProfiler.AddPhaseTicks(mPhase, ticks);
+		if (gTraceRecorder.IsEnabled())
+			gTraceRecorder.Add(PhaseName(mPhase), mStartTicks, ticks);
+	}
+	
+private:
+	const ProfilePhase	mPhase;
+	const int64_t		mStartTicks;
+	CounterValues		mStartCounts;
+};
+
+} // pong namespace
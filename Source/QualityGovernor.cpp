@@ -0,0 +1,105 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	QualityGovernor.cpp
+*****************************************************************************/
+
+#include "QualityGovernor.h"
+#include <algorithm>
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+const char* QualityStepName(QualityStep step)
+{
+	switch (step)
+	{
+		case eQualityFull:				return "full";
+		case eQualityFewerFragments:	return "fewerFragments";
+		case eQualityFewerTextBubbles:	return "fewerTextBubbles";
+		case eQualitySimpleShapes:		return "simpleShapes";
+		case eQualityNoMinimap:			return "noMinimap";
+		case eQualityCoarseCCD:			return "coarseCCD";
+		default:						return "?";
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+QualityGovernor::QualityGovernor(double budgetMS) :
+	mBudgetMS(budgetMS)
+{
+	std::fill(mFrameMS, mFrameMS + kRestoreWindow, 0.0);
+}
+
+/*---------------------------------------------------------------------------*/
+void QualityGovernor::SetEnabled(bool enabled)
+{
+	if (!enabled && mStep != eQualityFull)
+		this->SetStep(eQualityFull, "disabled", 0, 0, 0);
+	
+	mEnabled = enabled;
+	mNumFrames = 0;
+	mFramesSinceChange = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	EndFrame
+//   - a window only counts frames since the last change, so each step
+//     gets a full window to show what it did before the next one
+/*---------------------------------------------------------------------------*/
+void QualityGovernor::EndFrame(double frameMS, int32_t numObjects)
+{
+	if (!mEnabled)
+		return;
+	
+	mFrameMS[mNumFrames % kRestoreWindow] = frameMS;
+	mNumFrames++;
+	mFramesSinceChange++;
+	
+	if (mStep < (eNumQualitySteps - 1) && mFramesSinceChange >= kShedWindow)
+	{
+		const double avgMS = this->AverageMS(kShedWindow);
+		if (avgMS > (mBudgetMS * kShedFraction))
+		{
+			this->SetStep((QualityStep)(mStep + 1), "shed", avgMS, kShedWindow, numObjects);
+			return;
+		}
+	}
+	
+	if (mStep > eQualityFull && mFramesSinceChange >= kRestoreWindow)
+	{
+		const double avgMS = this->AverageMS(kRestoreWindow);
+		if (avgMS < (mBudgetMS * kRestoreFraction))
+			this->SetStep((QualityStep)(mStep - 1), "restored", avgMS, kRestoreWindow, numObjects);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	AverageMS
+//   - of the last numFrames (which are all in the ring)
+/*---------------------------------------------------------------------------*/
+double QualityGovernor::AverageMS(int32_t numFrames) const
+{
+	double total = 0;
+	for (int64_t k = (mNumFrames - numFrames); k < mNumFrames; k++)
+		total += mFrameMS[k % kRestoreWindow];
+	
+	return (total / numFrames);
+}
+
+/*---------------------------------------------------------------------------*/
+void QualityGovernor::SetStep(QualityStep step, const char* why, double avgMS, int32_t numFrames, int32_t numObjects)
+{
+	if (numFrames)
+		printf("quality: %s to step %d (%s) - last %d frames avg %.2f ms of %.0f ms, %d objects\n",
+			   why, step, QualityStepName(step), numFrames, avgMS, mBudgetMS, numObjects);
+	else
+		printf("quality: %s, back to step %d (%s)\n", why, step, QualityStepName(step));
+	
+	mStep = step;
+	mFramesSinceChange = 0;
+}
+
+} // pong namespace
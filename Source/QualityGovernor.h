@@ -0,0 +1,83 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	QualityGovernor.h
+	
+	Holds the frame budget when the object counts spike (an explosion storm
+	right after a level-up, bullet spam over a field of crawling icons) by
+	shedding cost in steps. It watches the recent frame times - when the
+	last few frames average too close to the budget it sheds the next step,
+	and once there's been plenty of headroom for a few seconds it restores
+	the last one. Every step change is logged.
+	
+	The steps are cumulative, cheapest-to-lose first - see QualityStep. The
+	game asks the governor (Sheds(), ScaleFragments(), ...) at each place a
+	step applies.
+	
+	On in the windowed game (unless --no-governor); headless runs are timed
+	with a fixed step, so they only turn it on with --governor.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <algorithm>
+
+namespace pong
+{
+
+// QualityStep - in the order they're shed (each step keeps the ones before it)
+enum QualityStep
+{
+	eQualityFull = 0,
+	eQualityFewerFragments,		// explosions throw half the fragments
+	eQualityFewerTextBubbles,	// at most kMaxTextBubbles on screen
+	eQualitySimpleShapes,		// rects instead of ellipses (image sprites are already native size)
+	eQualityNoMinimap,			// no minimap children (and the ones there aren't drawn)
+	eQualityCoarseCCD,			// bullets sweep with half the collision rects
+	eNumQualitySteps
+};
+
+const char* QualityStepName(QualityStep step);
+
+// QualityGovernor
+class QualityGovernor
+{
+public:
+	static const int32_t kShedWindow = 8;		// frames averaged to decide to shed
+	static const int32_t kRestoreWindow = 90;	// frames averaged to decide to restore (~3 sec)
+	static const int32_t kMaxTextBubbles = 2;
+	
+	// shed above this much of the budget, restore below this much
+	static constexpr double kShedFraction = 0.85;
+	static constexpr double kRestoreFraction = 0.5;
+	
+	QualityGovernor(double budgetMS);
+	
+	// turning it off goes straight back to full quality
+	void	SetEnabled(bool enabled);
+	bool	IsEnabled() const { return mEnabled; }
+	
+	// a frame took frameMS - this may shed or restore a step
+	void	EndFrame(double frameMS, int32_t numObjects);
+	
+	QualityStep	GetStep() const { return mStep; }
+	bool	Sheds(QualityStep step) const { return (mStep >= step); }
+	
+	int32_t	ScaleFragments(int32_t numFragments) const { return this->Sheds(eQualityFewerFragments) ? std::max(1, numFragments / 2) : numFragments; }
+	int32_t	ScaleBulletCollisionRects(int32_t numRects) const { return this->Sheds(eQualityCoarseCCD) ? std::max(1, numRects / 2) : numRects; }
+
+private:
+	double	AverageMS(int32_t numFrames) const;
+	void	SetStep(QualityStep step, const char* why, double avgMS, int32_t numFrames, int32_t numObjects);
+	
+	const double	mBudgetMS;
+	bool			mEnabled = false;
+	QualityStep		mStep = eQualityFull;
+	
+	double			mFrameMS[kRestoreWindow]; // a ring of the most recent
+	int64_t			mNumFrames = 0;
+	int64_t			mFramesSinceChange = 0;
+};
+
+} // pong namespace
@@ -0,0 +1,116 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	ShipTable.cpp
+*****************************************************************************/
+
+#include "ShipTable.h"
+#include <algorithm>
+#include <math.h>
+
+namespace pong
+{
+
+namespace
+{
+	const double kAngleStep = (2 * M_PI / ShipTable::kNumOrientations);
+	
+	// the ship, pointing up
+	const int32_t kBaseWidth = 16;
+	const int32_t kHeight = 8;
+	const int32_t kHalfBaseWidth = (kBaseWidth / 2);
+	const int32_t kHalfHeight = kHeight / 2;
+	const int32_t kCenterIndent = 4;
+	const int32_t kThrustWidth = ((kBaseWidth / 4) - 1);
+	const int32_t kThrustHeight = 8;
+	
+	const Point<double> kShip[ShipOrientation::kNumVertices] =
+	{
+		{-kHalfBaseWidth, kHalfHeight},					// bottomL
+		{0, kHalfHeight - kCenterIndent},				// bottomC
+		{kHalfBaseWidth, kHalfHeight},					// bottomR
+		{0, -kHalfHeight}								// top
+	};
+	
+	const Point<double> kThrust[ShipOrientation::kNumThrustVertices] =
+	{
+		{-kThrustWidth, kHalfHeight},					// bottomL
+		{0, kHalfHeight + kThrustHeight},				// bottomC
+		{kThrustWidth, kHalfHeight}						// bottomR
+	};
+	
+	/*---------------------------------------------------------------------------*/
+	Point<double> Rotate(const Point<double>& p, double sin, double cos)
+	{
+		return {(p.x * cos - p.y * sin), (p.x * sin + p.y * cos)};
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	Image FilledMask(const Point<double>* points, int32_t numPoints)
+	{
+		const Path p = ShipTable::ShapePath(points, numPoints);
+		
+		Image mask(Image::SingleChannel, ShipTable::kSpriteSize, ShipTable::kSpriteSize, true);
+		Graphics g(mask);
+		g.setColour(Colours::white);
+		g.fillPath(p, AffineTransform::translation((float)ShipTable::kSpriteOrigin, (float)ShipTable::kSpriteOrigin));
+		return mask;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+ShipTable::ShipTable()
+{
+	for (int32_t k = 0; k < kNumOrientations; k++)
+	{
+		ShipOrientation& o = mOrientations[k];
+		o.mSin = ::sin(k * kAngleStep);
+		o.mCos = ::cos(k * kAngleStep);
+		
+		for (int32_t j = 0; j < ShipOrientation::kNumVertices; j++)
+			o.mVertices[j] = Rotate(kShip[j], o.mSin, o.mCos);
+		
+		for (int32_t j = 0; j < ShipOrientation::kNumThrustVertices; j++)
+			o.mThrust[j] = Rotate(kThrust[j], o.mSin, o.mCos);
+		
+		o.mFront = Rotate({0, -kHalfHeight}, o.mSin, o.mCos);
+		
+		o.mMin = o.mMax = o.mVertices[0];
+		for (const Point<double>& v : o.mVertices)
+		{
+			o.mMin = {std::min(o.mMin.x, v.x), std::min(o.mMin.y, v.y)};
+			o.mMax = {std::max(o.mMax.x, v.x), std::max(o.mMax.y, v.y)};
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void ShipTable::BuildSprites()
+{
+	for (ShipOrientation& o : mOrientations)
+	{
+		o.mShipMask = FilledMask(o.mVertices, ShipOrientation::kNumVertices);
+		o.mThrustMask = FilledMask(o.mThrust, ShipOrientation::kNumThrustVertices);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+Path ShipTable::ShapePath(const Point<double>* points, int32_t numPoints)
+{
+	Path p;
+	p.startNewSubPath(points[0].toFloat());
+	for (int32_t k = 1; k < numPoints; k++)
+		p.lineTo(points[k].toFloat());
+	p.closeSubPath();
+	return p;
+}
+
+/*---------------------------------------------------------------------------*/
+int32_t ShipTable::Index(double angle)
+{
+	const int32_t k = (int32_t)::lround(angle / kAngleStep) % kNumOrientations;
+	return (k < 0 ? k + kNumOrientations : k);
+}
+
+} // pong namespace
@@ -0,0 +1,73 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	ShipTable.h
+	
+	The ship only ever points in one of 36 directions - it rotates in steps
+	of kRotateSpeed (pi/18) - so everything about it that depends on its
+	angle is worked out once, up front, for each direction: sin & cos, the
+	vertices, the thrust triangle, the front (where bullets come from), the
+	bounds, and the filled shapes. Animating & drawing the ship are then a
+	lookup plus a translation.
+	
+	All the points are offsets from the ship's position (the center of the
+	triangle). The shapes are single channel images, drawn in whatever
+	colour the ship is this frame - when the game is drawn scaled, the same
+	vertices are filled as paths instead, so the ship isn't a blurry
+	upscaled mask.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+namespace pong
+{
+
+// ShipOrientation
+struct ShipOrientation
+{
+	static const int32_t kNumVertices = 4;		// bottomL, bottomC, bottomR, top
+	static const int32_t kNumThrustVertices = 3;	// bottomL, bottomC, bottomR
+	
+	double			mSin = 0;
+	double			mCos = 0;
+	Point<double>	mVertices[kNumVertices];
+	Point<double>	mThrust[kNumThrustVertices];
+	Point<double>	mFront;
+	
+	// of mVertices
+	Point<double>	mMin;
+	Point<double>	mMax;
+	
+	// the ship & thrust, with the position at ShipTable::kSpriteOrigin in x & y
+	Image			mShipMask;
+	Image			mThrustMask;
+};
+
+// ShipTable
+class ShipTable
+{
+public:
+	static const int32_t kNumOrientations = 36;
+	static const int32_t kSpriteSize = 32;
+	static const int32_t kSpriteOrigin = (kSpriteSize / 2);
+	
+	// the geometry
+	ShipTable();
+	
+	// the masks - these need the graphics code, so they're made in TPongView::Init
+	void	BuildSprites();
+	
+	// the nearest of the 36 to angle (which can be any number of turns around)
+	static int32_t Index(double angle);
+	const ShipOrientation& Get(double angle) const { return mOrientations[Index(angle)]; }
+	
+	// a closed path through points (an orientation's vertices or thrust)
+	static Path ShapePath(const Point<double>* points, int32_t numPoints);
+
+private:
+	ShipOrientation mOrientations[kNumOrientations];
+};
+
+} // pong namespace
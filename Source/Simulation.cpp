@@ -0,0 +1,447 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	Simulation.cpp
+*****************************************************************************/
+
+#include "Simulation.h"
+#include "FlightRecorder.h"
+#include "FrameExporter.h"
+#include "TileRenderer.h"
+
+namespace
+{
+	using namespace pong;
+	
+	/*---------------------------------------------------------------------------*/
+	// ScriptedKeyDown - the key state for a given tick, so every run of a
+	// script sees exactly the same input
+	bool ScriptedKeyDown(InputScript script, int64_t tick, int32_t key)
+	{
+		if (script == eScriptIdle)
+			return false;
+		
+		const bool spin = (script == eScriptSpin || script == eScriptMixed);
+		const bool shoot = (script == eScriptShoot || script == eScriptMixed);
+		
+		// rotate for 40 ticks (just over a full turn) out of every 120
+		const bool rotating = spin && ((tick % 120) < 40);
+		
+		if (key == 'z')
+			return !rotating && ((tick % 8) < 2);
+		
+		if (key == KeyPress::rightKey)
+			return rotating && ((tick / 120) % 2 == 0);
+		
+		if (key == KeyPress::leftKey)
+			return rotating && ((tick / 120) % 2 == 1);
+		
+		if (key == 'x')
+			return shoot && ((tick % 4) == 0);
+		
+		return false;
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// PrintCounterReport - hardware counters per tick, next to each phase
+	void PrintCounterReport(int64_t numTicks)
+	{
+		const HardwareCounters& hw = gProfiler.GetHardwareCounters();
+		
+		printf("\n  %-14s %6s %8s", "per tick", "ipc", "counted");
+		for (int32_t c = 0; c < eNumHardwareCounters; c++)
+			printf(" %13s", CounterName((HardwareCounter)c));
+		printf("\n");
+		
+		for (int32_t k = 0; k < eNumProfilePhases; k++)
+		{
+			// scaled for the time the group was multiplexed off the PMU
+			const CounterValues& v = gProfiler.GetTotalPhaseCounters((ProfilePhase)k);
+			if (!v.IsCounted())
+			{
+				printf("  %-14s not counted (the kernel never scheduled the counters)\n", PhaseName((ProfilePhase)k));
+				continue;
+			}
+			
+			printf("  %-14s %6.2f %7.1f%%", PhaseName((ProfilePhase)k), v.IPC(), v.RunningFraction() * 100.0);
+			for (int32_t c = 0; c < eNumHardwareCounters; c++)
+			{
+				if (hw.IsAvailable((HardwareCounter)c))
+					printf(" %13.1f", v.Scaled((HardwareCounter)c) / numTicks);
+				else
+					printf(" %13s", "n/a");
+			}
+			printf("\n");
+		}
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// PrintLoadReport - frame cost by live object count, and where the budget breaks
+	void PrintLoadReport(const SimulationResult& r, double budgetMS)
+	{
+		printf("\n  objects   frames  frame ms");
+		for (int32_t k = 0; k < eNumProfilePhases; k++)
+			printf(" %14s", PhaseName((ProfilePhase)k));
+		printf("\n");
+		
+		int32_t frameBreak = -1;
+		int32_t phaseBreak[eNumProfilePhases];
+		std::fill(phaseBreak, phaseBreak + eNumProfilePhases, -1);
+		
+		for (size_t b = 0; b < r.mLoadBuckets.size(); b++)
+		{
+			const LoadBucket& bucket = r.mLoadBuckets[b];
+			if (!bucket.mNumFrames)
+				continue;
+			
+			const int32_t numObjects = (int32_t)(b * kLoadBucketSize);
+			const double frameMS = (bucket.mFrameMS / bucket.mNumFrames);
+			if (frameBreak < 0 && frameMS > budgetMS)
+				frameBreak = numObjects;
+			
+			printf("  %4d-%-4d %6lld %9.3f", numObjects, numObjects + kLoadBucketSize - 1,
+				   (long long)bucket.mNumFrames, frameMS);
+			
+			for (int32_t k = 0; k < eNumProfilePhases; k++)
+			{
+				const double phaseMS = (bucket.mPhaseMS[k] / bucket.mNumFrames);
+				if (phaseBreak[k] < 0 && phaseMS > budgetMS)
+					phaseBreak[k] = numObjects;
+				printf(" %14.3f", phaseMS);
+			}
+			printf("\n");
+		}
+		
+		printf("\n  frame budget (%.0f ms): ", budgetMS);
+		if (frameBreak >= 0)
+			printf("exceeded from %d objects\n", frameBreak);
+		else
+			printf("held up to %d objects\n", r.mMaxObjects);
+		
+		for (int32_t k = 0; k < eNumProfilePhases; k++)
+		{
+			if (phaseBreak[k] >= 0)
+				printf("  %-14s alone exceeds the budget from %d objects\n", PhaseName((ProfilePhase)k), phaseBreak[k]);
+		}
+	}
+}
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+String ArgValue(const StringArray& args, const String& name, const String& defaultValue)
+{
+	const int32_t index = args.indexOf(name);
+	return (index >= 0 && index + 1 < args.size()) ? args[index + 1] : defaultValue;
+}
+
+/*---------------------------------------------------------------------------*/
+GameMode GameModeFromName(const String& name)
+{
+	return 	name == "start" ? 		eStartScreen :
+			name == "asteroids" ? 	eAsteroids :
+			name == "hostage" ? 	eHostageRescue :
+			name == "gravity" ? 	eGravityShepherd :
+									eDistanceGame;
+}
+
+/*---------------------------------------------------------------------------*/
+const char* GameModeName(GameMode mode)
+{
+	switch (mode)
+	{
+		case eStartScreen:		return "start";
+		case eAsteroids:		return "asteroids";
+		case eDistanceGame:		return "distance";
+		case eHostageRescue:	return "hostage";
+		case eGravityShepherd:	return "gravity";
+		default:				return "";
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+InputScript InputScriptFromName(const String& name)
+{
+	return 	name == "idle" ? 	eScriptIdle :
+			name == "hover" ? 	eScriptHover :
+			name == "spin" ? 	eScriptSpin :
+			name == "shoot" ? 	eScriptShoot :
+								eScriptMixed;
+}
+
+/*---------------------------------------------------------------------------*/
+StressConfig StressConfigFromArgs(const StringArray& args)
+{
+	StressConfig c;
+	if (!args.contains("--stress"))
+		return c;
+	
+	c.mNumIcons = ArgValue(args, "--icons", "400").getIntValue();
+	c.mNumVectors = ArgValue(args, "--vectors", "40").getIntValue();
+	c.mNumGravity = ArgValue(args, "--gravity", "6").getIntValue();
+	c.mExplosionsPerSec = ArgValue(args, "--explosions", "20").getIntValue();
+	c.mBulletFansPerSec = ArgValue(args, "--fans", "4").getIntValue();
+	c.mBulletsPerFan = std::max(1, ArgValue(args, "--fan-size", String(c.mBulletsPerFan)).getIntValue());
+	c.mRampMS = (int64_t)(ArgValue(args, "--ramp", "60").getDoubleValue() * 1000);
+	return c;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RunSimulation
+/*---------------------------------------------------------------------------*/
+SimulationResult RunSimulation(const SimulationOptions& options)
+{
+	SimulationResult result;
+	
+	// the game uses ::rand() everywhere, so seeding it makes the run repeatable
+	srand(options.mSeed);
+	
+	IPongViewPtr pong = IPongView::Create(true);
+	result.mNumTicks = options.mNumTicks;
+	result.mStepMS = (options.mStepMS ? options.mStepMS : pong->GetRefreshrateMS());
+	
+	int64_t tick = 0;
+	const InputScript script = options.mScript;
+	pong->SetFixedStepMS(result.mStepMS);
+	pong->InstallKeyStateCallback([script, &tick](int32_t key) { return ScriptedKeyDown(script, tick, key); });
+	pong->SetGameMode(options.mMode);
+	pong->SetStressConfig(options.mStress);
+	pong->SetDirtyRectsEnabled(options.mDirtyRects, Colours::black);
+	pong->SetQualityGovernorEnabled(options.mGovernor);
+	
+	// render into an offscreen image, exactly like paint() (or the window's frame) would
+	Image frame(Image::ARGB, pong->GetGridWidth(), pong->GetGridHeight(), true);
+	Graphics g(frame);
+	
+	std::unique_ptr<TileRenderer> tiles;
+	if (options.mTileThreads > 0)
+		tiles.reset(new TileRenderer(options.mTileThreads));
+	
+	// the same recording played back untiled - kept between frames like the
+	// frame itself, for the dirty rects
+	Image reference;
+	if (tiles && options.mCheckTiles)
+		reference = Image(Image::ARGB, frame.getWidth(), frame.getHeight(), true);
+	
+	std::unique_ptr<FrameExporter> exporter;
+	if (options.mFramesDir.isNotEmpty())
+		exporter.reset(new FrameExporter(File(options.mFramesDir), options.mEncodeThreads > 0 ? options.mEncodeThreads : SystemStats::getNumCpus()));
+	
+	std::unique_ptr<FileOutputStream> csv;
+	if (options.mCSVPath.isNotEmpty())
+	{
+		const File csvFile(options.mCSVPath);
+		csvFile.deleteFile();
+		csv.reset(new FileOutputStream(csvFile));
+		
+		String header = "tick,game_ms,objects,frame_ms";
+		for (int32_t k = 0; k < eNumProfilePhases; k++)
+			header += String(",") + PhaseName((ProfilePhase)k) + "_ms";
+		*csv << header << "\n";
+	}
+	
+	gProfiler.SetEnabled(true);
+	gProfiler.Reset();
+	const double startMS = Time::getMillisecondCounterHiRes();
+	
+	for (tick = 0; tick < options.mNumTicks; tick++)
+	{
+		if (tiles)
+		{
+			tiles->Render(frame, [&](Graphics& tg)
+			{
+				if (!options.mDirtyRects)
+					tg.fillAll(Colours::black);
+				pong->Draw(tg);
+			});
+			
+			result.mTileRecordMS += tiles->GetRecordMS();
+			result.mTileRasterMS += tiles->GetRasterMS();
+			
+			if (reference.isValid())
+			{
+				tiles->ReplayUntiled(reference);
+				const int64_t diff = CountDifferentPixels(reference, frame);
+				if (diff)
+				{
+					if (result.mFirstTileMismatch < 0)
+						result.mFirstTileMismatch = tick;
+					result.mTileMismatchFrames++;
+					result.mTileMismatchPixels += diff;
+					
+					// start the next frame from the same pixels, so one bad frame isn't counted forever
+					reference = frame.createCopy();
+				}
+			}
+		}
+		else
+		{
+			if (!options.mDirtyRects)
+				g.fillAll(Colours::black);
+			pong->Draw(g);
+		}
+		
+		if (exporter)
+			exporter->Add(frame, tick);
+		
+		const int32_t numObjects = pong->GetNumActiveObjects();
+		result.mTotalObjects += numObjects;
+		result.mMaxObjects = std::max(result.mMaxObjects, numObjects);
+		
+		const size_t b = (size_t)(numObjects / kLoadBucketSize);
+		if (b >= result.mLoadBuckets.size())
+			result.mLoadBuckets.resize(b + 1);
+		
+		LoadBucket& bucket = result.mLoadBuckets[b];
+		bucket.mNumFrames++;
+		bucket.mFrameMS += gProfiler.GetLastFrameMS();
+		for (int32_t k = 0; k < eNumProfilePhases; k++)
+			bucket.mPhaseMS[k] += gProfiler.GetLastPhaseMS((ProfilePhase)k);
+		
+		if (csv)
+		{
+			String line = String((int64)tick) + "," + String((int64)(tick * result.mStepMS)) + "," +
+						  String(numObjects) + "," + String(gProfiler.GetLastFrameMS(), 4);
+			for (int32_t k = 0; k < eNumProfilePhases; k++)
+				line += "," + String(gProfiler.GetLastPhaseMS((ProfilePhase)k), 4);
+			*csv << line << "\n";
+		}
+	}
+	
+	result.mElapsedMS = (Time::getMillisecondCounterHiRes() - startMS);
+	result.mFrameMS = gProfiler.GetTotalFrameMS();
+	result.mMaxFrameMS = gProfiler.GetMaxFrameMS();
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+		result.mPhaseMS[k] = gProfiler.GetTotalPhaseMS((ProfilePhase)k);
+	result.mPool = PoolTelemetryFor(*pong);
+	
+	// the render loop is done - the rest of the encoding isn't part of its time
+	if (exporter)
+	{
+		exporter->Finish();
+		result.mFramesWritten = exporter->GetNumWritten();
+		result.mFramesFailed = exporter->GetNumFailed();
+		result.mEncodeThreads = exporter->GetNumThreads();
+		result.mEncodeMS = exporter->GetEncodeMS();
+		result.mEncodeWallMS = exporter->GetWallMS();
+		result.mEncodeStallMS = exporter->GetStallMS();
+	}
+	
+	pong->InstallKeyStateCallback(nullptr);
+	return result;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RunHeadless
+/*---------------------------------------------------------------------------*/
+int32_t RunHeadless(const StringArray& args)
+{
+	SimulationOptions options;
+	options.mNumTicks = ArgValue(args, "--ticks", String((int64)options.mNumTicks)).getLargeIntValue();
+	options.mStepMS = ArgValue(args, "--step", "0").getIntValue();
+	options.mSeed = ArgValue(args, "--seed", String(options.mSeed)).getIntValue();
+	options.mMode = GameModeFromName(ArgValue(args, "--mode", "distance"));
+	options.mScript = InputScriptFromName(ArgValue(args, "--script", "mixed"));
+	options.mStress = StressConfigFromArgs(args);
+	options.mCSVPath = ArgValue(args, "--csv", "");
+	options.mDirtyRects = args.contains("--dirty-rects");
+	options.mTileThreads = ArgValue(args, "--tiles", "0").getIntValue();
+	options.mCheckTiles = args.contains("--check-tiles");
+	if (options.mCheckTiles && options.mTileThreads <= 0)
+		options.mTileThreads = SystemStats::getNumCpus();
+	options.mFramesDir = ArgValue(args, "--frames-out", "");
+	options.mGovernor = args.contains("--governor");
+	options.mEncodeThreads = ArgValue(args, "--encoders", "0").getIntValue();
+	
+	// record the whole run - the ring keeps the most recent events if it's long
+	gTraceRecorder.SetEnabled(args.contains("--trace"));
+	
+	const bool counters = (args.contains("--counters") && gProfiler.EnableHardwareCounters());
+	
+	if (options.mNumTicks <= 0)
+	{
+		printf("headless: --ticks must be > 0\n");
+		return 1;
+	}
+	
+	const SimulationResult r = RunSimulation(options);
+	const int64_t n = r.mNumTicks;
+	
+	printf("headless: %lld ticks of %d ms, mode %s, seed %d%s\n",
+		   (long long)n, r.mStepMS, GameModeName(options.mMode), options.mSeed, options.mDirtyRects ? ", dirty rects" : "");
+	printf("  wall time:    %.1f ms\n", r.mElapsedMS);
+	printf("  ticks/sec:    %.1f\n", r.TicksPerSec());
+	printf("  frame:        avg %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", r.mFrameMS / n,
+		   gProfiler.GetFrameHistogram().GetPercentileMS(50), gProfiler.GetFrameHistogram().GetPercentileMS(99), r.mMaxFrameMS);
+	printf("  objects:      avg %.1f, max %d\n", (double)r.mTotalObjects / n, r.mMaxObjects);
+	if (options.mTileThreads > 0)
+		printf("  tiles:        %d threads, record avg %.3f ms, raster avg %.3f ms\n", options.mTileThreads, r.mTileRecordMS / n, r.mTileRasterMS / n);
+	if (options.mCheckTiles && r.mTileMismatchFrames)
+		printf("  tile check:   FAILED - %lld frames differ from the untiled playback (%lld pixels, first at tick %lld)\n",
+			   (long long)r.mTileMismatchFrames, (long long)r.mTileMismatchPixels, (long long)r.mFirstTileMismatch);
+	else if (options.mCheckTiles)
+		printf("  tile check:   every frame matches the untiled playback\n");
+	if (options.mFramesDir.isNotEmpty())
+	{
+		const double renderMS = r.mElapsedMS - r.mEncodeStallMS;
+		printf("  frames:       %lld written to %s, %lld failed\n", (long long)r.mFramesWritten, options.mFramesDir.toRawUTF8(), (long long)r.mFramesFailed);
+		printf("  render:       %.1f frames/sec (%.1f ms waiting for the encoders)\n", renderMS > 0 ? (n * 1000.0 / renderMS) : 0.0, r.mEncodeStallMS);
+		printf("  encode:       %.1f frames/sec on %d threads, %.2f ms/frame each\n",
+			   r.mEncodeWallMS > 0 ? (r.mFramesWritten * 1000.0 / r.mEncodeWallMS) : 0.0, r.mEncodeThreads,
+			   r.mFramesWritten > 0 ? (r.mEncodeMS / r.mFramesWritten) : 0.0);
+	}
+	
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+	{
+		const Histogram& h = gProfiler.GetPhaseHistogram((ProfilePhase)k);
+		printf("  %-14s %8.4f ms/tick  %5.1f%%   p50 %.4f  p99 %.4f  max %.4f\n", PhaseName((ProfilePhase)k), r.mPhaseMS[k] / n,
+			   r.mFrameMS > 0 ? (100.0 * r.mPhaseMS[k] / r.mFrameMS) : 0.0,
+			   h.GetPercentileMS(50), h.GetPercentileMS(99), h.GetMaxMS());
+	}
+	
+	if (counters)
+		PrintCounterReport(n);
+	
+	printf("\n");
+	r.mPool.Print();
+	
+	const String tracePath = ArgValue(args, "--trace", "");
+	if (tracePath.isNotEmpty())
+		gTraceRecorder.WriteJSON(File(tracePath), r.mElapsedMS / 1000.0 + 1);
+	
+	const String profilePath = ArgValue(args, "--profile-csv", "");
+	if (profilePath.isNotEmpty() && !gProfiler.WriteCSV(File(profilePath)))
+		printf("  could not write %s\n", profilePath.toRawUTF8());
+	
+	if (options.mStress.IsActive())
+		PrintLoadReport(r, r.mStepMS);
+	
+	return (options.mCheckTiles && r.mTileMismatchFrames) ? 1 : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DumpFlightRecording
+/*---------------------------------------------------------------------------*/
+int32_t DumpFlightRecording(const StringArray& args)
+{
+	const String inPath = ArgValue(args, "--dump-flight", "");
+	const String outPath = ArgValue(args, "--out", "");
+	
+	MemoryOutputStream csv;
+	if (inPath.isEmpty() || !FlightRecorder::DumpCSV(File(inPath), csv))
+	{
+		printf("not a flight recorder file: %s\n", inPath.toRawUTF8());
+		return 1;
+	}
+	
+	if (outPath.isEmpty())
+		printf("%s", csv.toString().toRawUTF8());
+	else if (!File(outPath).replaceWithText(csv.toString()))
+		return 1;
+	
+	return 0;
+}
+
+} // pong namespace
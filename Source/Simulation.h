@@ -0,0 +1,130 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	Simulation.h
+	
+	Runs the game without a window, audio or image files - the game is
+	advanced a fixed number of ticks as fast as possible with scripted input,
+	then ticks/sec, per-phase timings and object counts are reported.
+	
+	usage: SpaceForce --headless [--ticks N] [--step MS] [--seed N]
+	                             [--mode start|asteroids|distance|hostage|gravity]
+	                             [--script idle|hover|spin|shoot|mixed]
+	                             [--csv frames.csv] [--profile-csv summary.csv]
+	                             [--trace timeline.json] [--counters]
+	                             [--dirty-rects] [--tiles N [--check-tiles]]
+	                             [--governor] [--frames-out dir [--encoders N]]
+	
+	tiles:    --check-tiles also plays every tiled frame back untiled into a
+	          second image, and fails the run if a single pixel differs -
+	          add --dirty-rects to check the window's path
+	
+	frames:   --frames-out writes every frame as a numbered PNG (see
+	          FrameExporter.h) - use --mode start to render the recorded
+	          intro session, or any mode & script for a scripted one
+	
+	stress:   add --stress [--icons N] [--vectors M] [--gravity K]
+	                       [--explosions per-sec] [--fans per-sec]
+	                       [--fan-size N] [--ramp sec]
+	          to ramp the populations up over the run - the report then
+	          shows frame cost by live object count, and where the frame
+	          budget breaks (--stress works in the windowed game too)
+	
+	flight:   SpaceForce --dump-flight file.ring [--out frames.csv]
+	          prints (or writes) a flight recorder ring as CSV, oldest first
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SpaceForce.h"
+#include "Profiler.h"
+#include "PoolTelemetry.h"
+
+namespace pong
+{
+
+// InputScript - canned key presses, indexed by tick
+enum InputScript
+{
+	eScriptIdle,	// no keys at all
+	eScriptHover,	// short thrust bursts to fight gravity
+	eScriptSpin,	// hover plus long rotations (for the rotation scoring)
+	eScriptShoot,	// hover plus constant shooting
+	eScriptMixed	// all of the above
+};
+
+struct SimulationOptions
+{
+	int64_t		mNumTicks = 3000;
+	int32_t		mStepMS = 0; // 0 uses the game's refresh rate
+	int32_t		mSeed = 1;
+	GameMode	mMode = eDistanceGame;
+	InputScript	mScript = eScriptMixed;
+	StressConfig mStress;
+	String		mCSVPath; // per-frame log, if not empty
+	bool		mDirtyRects = false; // redraw only what changed, like the window does
+	int32_t		mTileThreads = 0; // > 0 rasterizes through a TileRenderer on this many threads
+	bool		mCheckTiles = false; // compare each tiled frame with the untiled playback
+	String		mFramesDir; // every frame as a PNG in here, if not empty
+	bool		mGovernor = false; // shed detail to hold the frame budget (see QualityGovernor.h)
+	int32_t		mEncodeThreads = 0; // 0 uses all the cores
+};
+
+// LoadBucket - frame cost for all the frames within a range of live object counts
+const int32_t kLoadBucketSize = 32;
+struct LoadBucket
+{
+	int64_t		mNumFrames = 0;
+	double		mFrameMS = 0;
+	double		mPhaseMS[eNumProfilePhases] = {};
+};
+
+struct SimulationResult
+{
+	int64_t		mNumTicks = 0;
+	int32_t		mStepMS = 0;
+	double		mElapsedMS = 0;
+	double		mFrameMS = 0;
+	double		mMaxFrameMS = 0;
+	double		mPhaseMS[eNumProfilePhases] = {};
+	int64_t		mTotalObjects = 0;
+	int32_t		mMaxObjects = 0;
+	
+	// with mTileThreads
+	double		mTileRecordMS = 0;
+	double		mTileRasterMS = 0;
+	
+	// with mCheckTiles
+	int64_t		mTileMismatchFrames = 0;
+	int64_t		mTileMismatchPixels = 0;
+	int64_t		mFirstTileMismatch = -1; // tick
+	
+	// with mFramesDir
+	int64_t		mFramesWritten = 0;
+	int64_t		mFramesFailed = 0;
+	int32_t		mEncodeThreads = 0;
+	double		mEncodeMS = 0;		// summed over the threads
+	double		mEncodeWallMS = 0;
+	double		mEncodeStallMS = 0;	// the render loop waiting for the encoders
+	
+	// indexed by (live objects / kLoadBucketSize)
+	std::vector<LoadBucket> mLoadBuckets;
+	
+	PoolTelemetry mPool;
+	
+	double TicksPerSec() const { return mElapsedMS > 0 ? (mNumTicks * 1000.0 / mElapsedMS) : 0.0; }
+};
+
+GameMode			GameModeFromName(const String& name);
+const char*			GameModeName(GameMode mode);
+InputScript			InputScriptFromName(const String& name);
+String				ArgValue(const StringArray& args, const String& name, const String& defaultValue);
+StressConfig		StressConfigFromArgs(const StringArray& args);
+SimulationResult	RunSimulation(const SimulationOptions& options);
+
+// returns the process exit code
+int32_t RunHeadless(const StringArray& args);
+int32_t DumpFlightRecording(const StringArray& args);
+
+} // pong namespace
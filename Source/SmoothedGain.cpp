@@ -0,0 +1,55 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	SmoothedGain.cpp
+*****************************************************************************/
+
+#include "SmoothedGain.h"
+#include <algorithm>
+
+/*---------------------------------------------------------------------------*/
+SmoothedGain::SmoothedGain() :
+	mTarget(1.0f)
+{
+	for (int32_t k = 0; k < kChunkSize; k++)
+		mIndex[k] = (float)(k + 1);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Process
+//   - a ramp's last sample is exactly the target, so the next block carries
+//     on from there
+/*---------------------------------------------------------------------------*/
+void SmoothedGain::Process(AudioBuffer<float>& buffer, int32_t startSample, int32_t numSamples)
+{
+	const float target = mTarget.load(std::memory_order_relaxed);
+	const int32_t numChannels = buffer.getNumChannels();
+	if (numSamples <= 0)
+		return;
+	
+	// steady
+	if (target == mCurrent)
+	{
+		if (mCurrent != 1.0f)
+		{
+			for (int32_t c = 0; c < numChannels; c++)
+				FloatVectorOperations::multiply(buffer.getWritePointer(c, startSample), mCurrent, numSamples);
+		}
+		return;
+	}
+	
+	// ramping - sample k of the block gets mCurrent + (k + 1) * step
+	const float step = (target - mCurrent) / numSamples;
+	for (int32_t offset = 0; offset < numSamples; offset += kChunkSize)
+	{
+		const int32_t n = std::min(kChunkSize, numSamples - offset);
+		FloatVectorOperations::copyWithMultiply(mRamp, mIndex, step, n);
+		FloatVectorOperations::add(mRamp, mCurrent + (step * offset), n);
+		
+		for (int32_t c = 0; c < numChannels; c++)
+			FloatVectorOperations::multiply(buffer.getWritePointer(c, startSample + offset), mRamp, n);
+	}
+	
+	mCurrent = target;
+}
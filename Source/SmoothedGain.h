@@ -0,0 +1,51 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	SmoothedGain.h
+	
+	The music's gain stage. The message thread sets a target (each song has
+	its own gain) and the audio thread picks it up at the start of its next
+	block, ramping linearly from the old gain to the new one across that
+	block instead of jumping - so a song change doesn't click.
+	
+	The work is all FloatVectorOperations (SIMD): a steady gain is one
+	multiply per channel, and a ramp is built once per block (in chunks of
+	kChunkSize, so nothing is allocated on the audio thread) and multiplied
+	into each channel. Unity gain that isn't changing skips the buffer
+	entirely.
+	
+	This lives in the global namespace (like IPongView) so MainComponent,
+	which has its own 'pong', can use it.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+// SmoothedGain
+class SmoothedGain
+{
+public:
+	static const int32_t kChunkSize = 512; // samples of ramp built at a time
+	
+	SmoothedGain();
+	
+	// any thread
+	void	SetTarget(float gain) { mTarget.store(gain, std::memory_order_relaxed); }
+	float	GetTarget() const { return mTarget.load(std::memory_order_relaxed); }
+	
+	// audio thread - applies the gain to numSamples of every channel
+	void	Process(AudioBuffer<float>& buffer, int32_t startSample, int32_t numSamples);
+	float	GetCurrent() const { return mCurrent; }
+	
+	// audio thread (or before it's used) - straight to gain, no ramp
+	void	Reset(float gain) { mTarget.store(gain, std::memory_order_relaxed); mCurrent = gain; }
+
+private:
+	std::atomic<float>	mTarget;
+	float				mCurrent = 1.0f;	// where the last block ended
+	
+	float				mIndex[kChunkSize];	// 1, 2, 3, ...
+	float				mRamp[kChunkSize];
+};
@@ -13,6 +13,20 @@
 *****************************************************************************/
 
 #include "SpaceForce.h"
+#include "Profiler.h"
+#include "Benchmark.h"
+#include "Simulation.h"
+#include "FlightRecorder.h"
+#include "PoolTelemetry.h"
+#include "DirtyRegion.h"
+#include "CachedLayer.h"
+#include "SpriteAtlas.h"
+#include "TextCache.h"
+#include "ParticleSystem.h"
+#include "TerrainPath.h"
+#include "ShipTable.h"
+#include "TileRenderer.h"
+#include "QualityGovernor.h"
 #include <list>
 #include <map>
 #include <math.h>
@@ -36,15 +50,6 @@ const bool kDoHostageRescueGame = false;
 
 static_assert(!(kDoDistanceGame && kDoHostageRescueGame));
 
-enum GameMode
-{
-	eStartScreen,
-	eAsteroids,
-	eDistanceGame,
-	eHostageRescue,
-	eGravityShepherd,
-};
-
 GameMode sGameMode = eDistanceGame;
 
 enum DistanceGameStatus
@@ -85,6 +90,9 @@ const bool kFreezeShipInMiddle = false;
 
 const int32_t kGroundMidpoint = 300;
 
+// how far back 'C' looks when capturing the trace timeline
+const double kTraceCaptureSeconds = 10;
+
 // minimap settings
 const int32_t kMinimapHeight = 30;
 const int32_t kMinimapOuterRatio = 4;
@@ -128,6 +136,19 @@ const String cGlidePathLogoImagePath = kSpecialImagesFolder + "GP.png";
 	
 const int32_t kGridHeight = 800;
 const int32_t kGridWidth = 1200;
+
+// the 'F' & 'O' overlays
+const CRect kProfilerOverlayBounds(kGridWidth - 420, 40, 400, 320);
+const CRect kPoolOverlayBounds(20, 40, 410, 270);
+
+// the level/hp/objects text on the left & the controls on the right
+const CRect kStatusBarBounds(50, kGridHeight - 80, kGridWidth - 100, 30);
+
+// the score stats under the first line, which changes too often to cache
+const CRect kScoreStatsLayerBounds(kGridWidth - 400, 26, 360, kGridHeight - 150);
+
+// object bounds grow by this much in the dirty region (antialiasing & line widths)
+const int32_t kDirtyMargin = 3;
 	
 enum RotationDirection
 {
@@ -206,11 +227,24 @@ void MapFromString(const std::string& str, ScoreEventMap& map)
 	}
 }
 
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DrawImageIn
+//   - draw img centred in r - at its native size that's a plain blit at the
+//     nearest whole pixel, only scaled draws go through JUCE's resampling
+/*---------------------------------------------------------------------------*/
+void DrawImageIn(const Image& img, const Rectangle<float>& r, Graphics& g)
+{
+	if ((int32_t)r.getWidth() == img.getWidth() && (int32_t)r.getHeight() == img.getHeight())
+		g.drawImageAt(img, roundToInt(r.getX()), roundToInt(r.getY()));
+	else
+		g.drawImage(img, r, RectanglePlacement::centred);
+}
+
 /*---------------------------------------------------------------------------*/
 void DrawImageAt(Image& img, float x, float y, Graphics& g)
 {
 	const Rectangle<float> r(x, y, img.getWidth(), img.getHeight());
-	g.drawImage(img, r, RectanglePlacement::centred);
+	DrawImageIn(img, r, g);
 }
 	
 const int32_t kNumSamples = 20; // ~1 sec
@@ -262,9 +296,8 @@ SlidingAverage gSlidingAverage;
 class StFontRestorer
 {
 public:
-	StFontRestorer(Font newFont, Graphics& g) :
+	StFontRestorer(const Font& newFont, Graphics& g) :
 		mG(g),
-		mNewFont(newFont),
 		mCurrentFont(g.getCurrentFont())
 	{
 		mG.setFont(newFont);
@@ -276,7 +309,6 @@ public:
 	
 private:
 	Graphics& mG;
-	const Font mNewFont;
 	const Font mCurrentFont;
 };
 
@@ -339,6 +371,26 @@ bool CheckDeadline(int64_t targetMS)
 	return targetMS && gNowMS > targetMS;
 }
 
+// scripted key state for headless runs - when not installed we ask the keyboard
+std::function<bool(int32_t)> gKeyStateCallback = nullptr;
+
+/*---------------------------------------------------------------------------*/
+bool IsKeyDown(int32_t key)
+{
+	return gKeyStateCallback ? gKeyStateCallback(key) : KeyPress::isKeyCurrentlyDown(key);
+}
+
+/*---------------------------------------------------------------------------*/
+// stand-in sprite for headless runs, which don't touch the image files
+Image PlaceholderImage(int32_t size, Colour color)
+{
+	Image img(Image::ARGB, size, size, true);
+	Graphics g(img);
+	g.setColour(color);
+	g.fillEllipse(0, 0, size, size);
+	return img;
+}
+
 // CVector
 // do the math in doubles to handle rounding
 struct CVector
@@ -582,6 +634,7 @@ public:
 		mGroundObjectForHostage(nullptr),
 		mImage(nullptr),
 		mImageName(""),
+		mSprite(nullptr),
 		mWidth(0),
 		mHeight(0),
 		mNext(nullptr),
@@ -610,12 +663,14 @@ public:
 	void		GetPredefinedShipData();
 	void		AnimateChaser();
 	void		AnimateMiniMapObject();
-	void		Draw(Graphics& g);
+	void		Draw(Graphics& g, SpriteBatch* batch = nullptr);
 	void		DrawShip(Graphics& g);
-	void		DrawGroundObject(Graphics& g);
+	void		UpdateGroundObject();
 	void		DrawTextBubble(Graphics& g);
 	void		DrawBullet(Graphics& g);
+	CRect		DrawBounds() const;
 	void 		InitGround(bool isBottom);
+	CVector		GroundRightEndpoint() const { return {mState.mPos.mX + mWidth, mState.mPos.mY + mHeight}; }
 	
 	EObjectType		Type() const { return mType; }
 	
@@ -678,7 +733,6 @@ public:
 	CVector	FlatEarthDockPoint() const { return CVector(mState.mPos.mX, mState.mPos.mY - 25); }
 	
 	// for ship object
-	void			Rotate(CPointF& p, const CPointF& c);
 	void			GetControlData();
 	void			CheckRotation(bool isRotating);
 	double			GetAngle() const { return mAngle; }
@@ -700,6 +754,8 @@ public:
 	void		SetNext(CObject* next) { mNext = next; }
 	CObject*	GetNext() { return mNext; }
 	bool		InUse() const { return mInUse; }
+	const CRect& GetDrawnBounds() const { return mDrawnBounds; }
+	void		SetDrawnBounds(const CRect& r) { mDrawnBounds = r; }
 	
 	
 	/*---------------------------------------------------------------------------*/
@@ -749,6 +805,7 @@ protected:
 	// only used by bullets to support CCD (Continuous Collision Detection)
 	#define						kNumBulletCollisionRects 8
 	CRect						mBulletCollisionRects[kNumBulletCollisionRects];
+	int32_t						mNumBulletCollisionRects = kNumBulletCollisionRects; // fewer when the governor sheds CCD
 	
 private:
 	void Init();
@@ -756,6 +813,7 @@ private:
 	// image data
 	Image* mImage;
 	std::string mImageName;
+	const Sprite* mSprite; // mImage in the view's atlas, if it's there
 	
 	// for TextBubble object
 	std::string mTextBubbleText;
@@ -767,6 +825,7 @@ private:
 	// for use with CObjectPool
 	CObject* mNext;
 	bool mInUse;
+	CRect mDrawnBounds; // DrawBounds() as of the last frame, for the dirty region
 	
 	CObject* mParent;
 	CObject* mChild;
@@ -777,6 +836,7 @@ private:
 	double		mAngleCos;
 	CPointF		mFront;
 	std::vector<CPointI> mThrustVertices;
+	const ShipOrientation* mOrientation = nullptr; // as of the last AnimateShip
 	bool		mThrusting;
 	int64_t		mDockedToEarthMS;
 	
@@ -803,6 +863,8 @@ public:
 	void Init()
 	{
 		mFirstOpenSlot = &mPool[0];
+		mNumObjectsInUse = 0;
+		mTelemetry.Reset(kMaxNumObjects);
 		
 		// init mNext on all objects
 		for (int k = 0; k < kMaxNumObjects; k++)
@@ -812,14 +874,23 @@ public:
 	// NewObject
 	CObject* NewObject(TPongView* pongView, const EObjectType type, const CState state)
 	{
+		static_assert(eTextBubble == (1 << (kNumObjectTypes - 1)));
+		
 		// if we hit this assert then we've exceeded kMaxNumObjects
 		CMN_DEBUGASSERT(mFirstOpenSlot != nullptr);
 		if (mFirstOpenSlot == nullptr)
+		{
+			mTelemetry.AllocationFailed(ObjectTypeIndex(type));
 			return nullptr;
+		}
 		
 		// find the next open memory slot
 		CObject* newObject = mFirstOpenSlot;
 		mFirstOpenSlot = newObject->GetNext();
+		mNumObjectsInUse++;
+		
+		mAllocTimeMS[newObject - mPool] = gNowMS;
+		mTelemetry.Allocated(ObjectTypeIndex(type));
 
 		// use placement new to construct the object at the open memory slot in the pool
 		// (no heap allocations)
@@ -855,20 +926,67 @@ public:
 			if (!obj.IsAlive())
 			{
 				obj.Died();	// object-specific cleanup
-				
-				// release this slot back into the pool (not thread safe)
-				obj.Free();
-				obj.SetNext(mFirstOpenSlot);
-				mFirstOpenSlot = &obj;
-				
-				if (obj.Is(eGround))
-					mGroundObjectList.remove(&obj);
+				this->FreeObject(obj);
 			}
 		}
 	}
 	
+	// FreeObject
+	// release the object's slot back into the pool (not thread safe)
+	void FreeObject(CObject& obj)
+	{
+		mTelemetry.Freed(ObjectTypeIndex(obj.Type()), gNowMS - mAllocTimeMS[&obj - mPool]);
+		
+		// what it left on the screen needs clearing
+		if (mDirtyRegion)
+			mDirtyRegion->Add(obj.GetDrawnBounds());
+		
+		obj.Free();
+		obj.SetNext(mFirstOpenSlot);
+		mFirstOpenSlot = &obj;
+		mNumObjectsInUse--;
+		
+		if (obj.Is(eGround))
+			mGroundObjectList.remove(&obj);
+	}
+	
+	// FreeAllObjectsOfType
+	// release the objects directly - unlike KillAllObjectsOfType there are no
+	// explosions or Died() callbacks
+	void FreeAllObjectsOfType(int32_t types)
+	{
+		for (int32_t k = 0; k < kMaxNumObjects; k++)
+		{
+			CObject& obj = mPool[k];
+			if (obj.InUse() && obj.IsOneOf(types))
+				this->FreeObject(obj);
+		}
+	}
+	
+	// AddDirtyBounds
+	// where each object was drawn last frame & where it's about to be drawn,
+	// for the ones that moved - the ship & text bubbles change in place too
+	void AddDirtyBounds(DirtyRegion& region)
+	{
+		for (int k = 0; k < kMaxNumObjects; k++)
+		{
+			CObject& obj = mPool[k];
+			if (!obj.InUse())
+				continue;
+			
+			const CRect bounds = (obj.IsActive() ? obj.DrawBounds() : CRect());
+			if (bounds == obj.GetDrawnBounds() && !obj.IsOneOf(eShip | eTextBubble))
+				continue;
+			
+			region.Add(obj.GetDrawnBounds());
+			region.Add(bounds);
+			obj.SetDrawnBounds(bounds);
+		}
+	}
+	
 	// Draw
-	// draw all the objects
+	// draw all the objects - sprites go through the batch, which gets flushed
+	// before anything else draws so the order stays the same
 	void Draw(Graphics& g)
 	{
 		for (int k = 0; k < kMaxNumObjects; k++)
@@ -877,8 +995,10 @@ public:
 			if (!obj.IsActive())
 				continue;
 			
-			obj.Draw(g);
+			obj.Draw(g, &mSpriteBatch);
 		}
+		
+		mSpriteBatch.Flush(g);
 	}
 	
 	// CheckCollision
@@ -997,7 +1117,25 @@ public:
 		}
 	}
 	
+	// CountObjectsOfType
+	int32_t CountObjectsOfType(int32_t types) const
+	{
+		int32_t count = 0;
+		for (int32_t k = 0; k < kMaxNumObjects; k++)
+		{
+			const CObject& obj = mPool[k];
+			if (obj.IsActive() && obj.IsOneOf(types))
+				count++;
+		}
+		return count;
+	}
+	
 	int32_t GetNumActiveObjects() const { return mNumActiveObjects; }
+	
+	int32_t GetNumFreeSlots() const { return kMaxNumObjects - mNumObjectsInUse; }
+	const PoolTelemetry& GetTelemetry() const { return mTelemetry; }
+	void SetDirtyRegion(DirtyRegion* region) { mDirtyRegion = region; }
+	void SetSpriteScale(float scale, std::shared_ptr<const ScaledSprites::Set> scaled) { mSpriteBatch.SetScale(scale, std::move(scaled)); }
 	void ApplyGravity(CObject& o1, CObject& o2);
 	
 private:
@@ -1005,6 +1143,16 @@ private:
 	CObject* mFirstOpenSlot;
 	std::list<CObject*> mGroundObjectList;
 	int32_t mNumActiveObjects;
+	int32_t mNumObjectsInUse;
+	
+	// telemetry - gNowMS when each slot was handed out, for the lifetimes
+	PoolTelemetry mTelemetry;
+	int64_t mAllocTimeMS[kMaxNumObjects];
+	
+	// only set when the view is drawing dirty rects
+	DirtyRegion* mDirtyRegion = nullptr;
+	
+	SpriteBatch mSpriteBatch;
 };
 
 
@@ -1012,7 +1160,7 @@ private:
 class TPongView : public IPongView
 {
 public:
-	TPongView() :
+	TPongView(bool headless) :
 		mShipObject(nullptr),
 		mFlatEarthObject(nullptr),
 		mChaserObject(nullptr),
@@ -1040,6 +1188,9 @@ public:
 		mShipHasGravity(!kUseIntroScreens),
 		mAutoSmartBombMode(false),
 		mIsPaused(false),
+		mShowProfiler(false),
+		mWriteProfile(false),
+		mShowPoolTelemetry(false),
 		mNumGravityObjects(0),
 		mBlackHoleEnabled(false),
 		mFlatEarthEnabled(false),
@@ -1048,9 +1199,11 @@ public:
 		mIntroScreenChangedTimeMS(0),
 		mDistanceGameStatus(kDoDistanceGame ? eActive : eInactive),
 		mMusicCallback(nullptr),
-		mRotaryCallback(nullptr)
+		mRotaryCallback(nullptr),
+		mHeadless(headless),
+		mFixedStepMS(0)
 	{}
-	~TPongView() {}
+	~TPongView();
 	
 	// public interface
 	virtual void Draw(Graphics& g) override;
@@ -1063,6 +1216,14 @@ public:
 	virtual void InstallHighScoreCallback(std::function<void(std::string)> f) override { mHighScoreCallback = f; }
 	virtual Colour ColorForScore(int32_t score) override;
 	void SetHighScore(std::string score) override;
+	virtual void SetFixedStepMS(int32_t stepMS) override { mFixedStepMS = stepMS; }
+	virtual void InstallKeyStateCallback(std::function<bool(int32_t)> f) override { gKeyStateCallback = f; }
+	virtual void SetGameMode(GameMode mode) override;
+	virtual int32_t GetNumActiveObjects() override { return mObjectPool.GetNumActiveObjects() + mParticles.GetNumParticles(); }
+	virtual void SetStressConfig(const StressConfig& config) override;
+	virtual void SetDirtyRectsEnabled(bool enabled, Colour background) override;
+	virtual RectangleList<int> GetDirtyRectangles() override;
+	double GetDirtyCoverage() const { return mDirtyRectsEnabled ? mDirtyRegion.GetCoverage() : 1.0; }
 	void Animate();
 	void CheckKeyPresses();
 	void CreateNewObjects();
@@ -1074,12 +1235,16 @@ public:
 	void DoExplosions();
 	bool CheckKeyPress(char key, int32_t throttleMS);
 	void VectorObjectDied();
+	void GroundObjectDied(bool isBottom) { this->Terrain(isBottom).DropFirst(); }
 	void ChaserObjectDied();
 	void HostageObjectDied();
 	bool LevelPause() const { return mShowLevelTextUntilMS != 0; }
 	int32_t GetGridWidth() const { return kGridWidth; }
 	int32_t GetGridHeight() const { return kGridHeight; }
 	CObjectPool& GetObjectPool() { return mObjectPool; }
+	ParticleSystem& GetParticles() { return mParticles; }
+	TerrainPath& Terrain(bool isBottom) { return isBottom ? mBottomTerrain : mTopTerrain; }
+	void DrawTerrain(Graphics& g);
 	void AddKill() { mKills++; }
 	void AddDeath() { mDeaths++; }
 	void Explosion(const CVector& pos, bool isShip = false);
@@ -1091,6 +1256,14 @@ public:
 	Image& GetFlatEarthImage() { return mFlatEarthImage; }
 	Image& GetHostageImage(EHostageType type) { return mHostageImage[type]; }
 	Image& GetBulletImage() { return mBulletImage; }
+	const SpriteAtlas& GetSpriteAtlas() const { return mSpriteAtlas; }
+	const ShipTable& GetShipTable() const { return mShipTable; }
+	float GetRenderScale() const { return mRenderScale; }
+	TextCache& GetTextCache() { return mTextCache; }
+	const QualityGovernor& GetQualityGovernor() const { return mGovernor; }
+	virtual void SetQualityGovernorEnabled(bool enabled) override { mGovernor.SetEnabled(enabled); }
+	virtual void SetRenderScale(float scale) override;
+	const Font& GetTextBubbleFont() const { return mTextBubbleFont; }
 	
 	Image& GetChaserImage() { return mChaserImage; }
 	CVector& GetChaserPosition();
@@ -1112,6 +1285,8 @@ private:
 	
 	void			Init();
 	void			Free();
+	Image			LoadImage(const String& path, int32_t placeholderSize) const;
+	void			DrawHud(Graphics& g);
 	void			DrawText(Graphics& g);
 	void			DrawIntroScreens(Graphics& g);
 	void 			DrawIntroText(std::string text, Graphics& g, bool start = false);
@@ -1120,6 +1295,10 @@ private:
 	void			DrawDistanceMeter(Graphics& g);
 	void			HandleIntroWindow(Graphics& g);
 	void			DrawGameOptionRect(std::string text, CVector leftCorner, Graphics& g);
+	void			ClipToDirtyRegion(Graphics& g);
+	void			HudText(const CRect& rect, const std::string& text);
+	template <typename F>
+	void			DrawLayer(CachedLayer& layer, uint64_t key, Graphics& g, F render);
 	void			NewFallingIconObject();
 	void			NewCrawlingIconObject();
 	void			NewChaserObject();
@@ -1128,12 +1307,16 @@ private:
 	void			NewVectorIconObject();
 	void			ShootBullet(const pong::CVector& pos, const pong::CVector& vel);
 	void			ShootBullets();
+	void			ShootBulletFan(int32_t numBullets);
+	void			UpdateStress(double diffSec);
+	void			RecordFlightFrame(int64_t intervalMS);
 	void			SmartBomb();
 	int32_t			ScoreForEvent(ScoringEvent ev) const;
 	std::string 	TextForScoreEvent(ScoringEvent ev) const;
 	std::string 	LabelForScoreEvent(ScoringEvent ev) const;
 	Colour 			TextColorForScoreEvent(ScoringEvent ev) const;
 	void			ShowScoreStats(Graphics& g);
+	void			RenderScoreStats(Graphics& g);
 	void 			ScoreStatsUI(std::map<ScoringEvent, int32_t>& list, int32_t x, int32_t& y, Graphics& g);
 	
 private:
@@ -1176,6 +1359,10 @@ public:
 	bool			mShipHasGravity;
 	bool			mAutoSmartBombMode;
 	bool			mIsPaused;
+	bool			mShowProfiler;
+	bool			mWriteProfile; // asked for (--profile, --stress or 'F') - not just on for the flight recorder
+	bool			mShowPoolTelemetry;
+	File			mPoolCSVFile; // where the pool telemetry goes at exit, if anywhere
 	int32_t    		mNumGravityObjects;
 	bool			mBlackHoleEnabled;
 	bool			mFlatEarthEnabled;
@@ -1223,11 +1410,61 @@ public:
 	std::map<EHostageType, Image> mHostageImage;
 	Image				mBulletImage;
 	Image				mGlidePathLogoImage;
+	SpriteAtlas			mSpriteAtlas; // all of the above that are loaded up front
+	ScaledSprites		mScaledSprites; // the atlas at mRenderScale
+	float				mRenderScale = 1.0f;
+	ShipTable			mShipTable;
 	int32_t				mGravityIndex;
 	std::map<char, int64_t> mLastKeyPressTimeMS;
 	bool				mMinimapActive = false;
 	
+	// headless runs use placeholder images and a fixed time step
+	const bool			mHeadless;
+	int32_t				mFixedStepMS;
+	
+	// stress mode
+	StressConfig		mStressConfig;
+	int64_t				mStressStartMS = 0;
+	int64_t				mStressNextLogMS = 0;
+	double				mStressExplosions = 0; // fractional explosions owed
+	double				mStressBulletFans = 0; // fractional fans owed
+	
+	// hitch flight recorder (windowed game only)
+	std::unique_ptr<FlightRecorder> mFlightRecorder;
+	
+	// sheds detail when the frames get close to kRefreshRateMS
+	QualityGovernor		mGovernor{kRefreshRateMS};
+	
+	// dirty rects - Draw() only clears & redraws what changed since the last
+	// frame (the caller keeps the frame between calls)
+	bool				mDirtyRectsEnabled = false;
+	Colour				mBackgroundColour = Colours::black;
+	DirtyRegion			mDirtyRegion;
+	int64_t				mDirtyScene = -1; // see ClipToDirtyRegion
+	DrawList			mHudList; // the HUD, recorded before the clip (see Draw)
+	
+	// static layers - see CachedLayer.h
+	CachedLayer			mBackgroundLayer;	// logo & minimap outline
+	CachedLayer			mControlsLayer;		// the right side of the status bar
+	CachedLayer			mIntroWindowLayer;	// the start screen's game options
+	CachedLayer			mScoreStatsLayer;
+	bool				mRenderingLayer = false; // layer text isn't HUD text
+	
+	// text - the fonts are made once in Init, and the layouts are cached
+	Font				mFont14;
+	Font				mFont22;
+	Font				mChalkboardFont;
+	Font				mTextBubbleFont;
+	TextCache			mTextCache;
+	std::string			mStatusText;
+	uint64_t			mStatusTextKey = 0;
+	int32_t				mStatusObjects = 0;		// the count shown, sampled every kStatusObjectsMS
+	int64_t				mStatusObjectsMS = 0;
+	
 	CObjectPool		mObjectPool;
+	ParticleSystem	mParticles; // explosion fragments
+	TerrainPath		mBottomTerrain;
+	TerrainPath		mTopTerrain;
 	
 	friend IPongView;
 	typedef std::shared_ptr<TPongView> PongViewPtr;
@@ -1241,9 +1478,9 @@ bool HasUpperLine() { return HostageRescueGameActive() || sGameMode == eDistance
 // 	METHOD:	Create - factory
 //  tbarram 3/13/17
 /*---------------------------------------------------------------------------*/
-IPongViewPtr IPongView::Create()
+IPongViewPtr IPongView::Create(bool headless)
 {
-	TPongView::PongViewPtr pongView = std::make_shared<TPongView>();
+	TPongView::PongViewPtr pongView = std::make_shared<TPongView>(headless);
 	pongView->Init();
 	return pongView;
 }
@@ -1264,6 +1501,15 @@ void LoadFilesFromFolder(const String& dir, std::vector<Image>& images)
 	}
 }
 
+/*---------------------------------------------------------------------------*/
+Image TPongView::LoadImage(const String& path, int32_t placeholderSize) const
+{
+	if (mHeadless)
+		return PlaceholderImage(placeholderSize, Colours::ivory);
+	
+	return ImageFileFormat::loadFrom(File(path));
+}
+
 /*---------------------------------------------------------------------------*/
 // 	METHOD:	Init
 //  tbarram 4/29/17
@@ -1278,11 +1524,25 @@ void TPongView::Init()
 	mNextDistanceGameStartTimeMS = (gNowMS + kIntervalBetweenGames);
 	mNextHostageObjectMS = (gNowMS + 10000);
 	
-	mHostageImage[eSoldier] = ImageFileFormat::loadFrom(File(cHostageImagePath_Soldier));
-	mHostageImage[eBoss] = ImageFileFormat::loadFrom(File(cHostageImagePath_Boss));
-	mHostageImage[eFriend] = ImageFileFormat::loadFrom(File(cHostageImagePath_Friend));
-	mBulletImage = ImageFileFormat::loadFrom(File(cBulletImagePath));
-	mGlidePathLogoImage = ImageFileFormat::loadFrom(File(cGlidePathLogoImagePath));
+	mHostageImage[eSoldier] = this->LoadImage(cHostageImagePath_Soldier, 32);
+	mHostageImage[eBoss] = this->LoadImage(cHostageImagePath_Boss, 24);
+	mHostageImage[eFriend] = this->LoadImage(cHostageImagePath_Friend, 32);
+	mBulletImage = this->LoadImage(cBulletImagePath, 12);
+	mGlidePathLogoImage = this->LoadImage(cGlidePathLogoImagePath, 48);
+	
+	mFont14 = Font(14.0f);
+	mFont22 = Font(22.0f);
+	mChalkboardFont = Font("Chalkboard", 28, 0);
+	mTextBubbleFont = Font("helvetica", 18, 0);
+	
+	{
+		const CRect logo(86, 16, mGlidePathLogoImage.getWidth(), mGlidePathLogoImage.getHeight());
+		const CRect minimap(kMiniMapOuterTopLeftCorner.mX, kMiniMapOuterTopLeftCorner.mY, kMinimapOuterWidth, kMinimapOuterHeight);
+		mBackgroundLayer.SetBounds(logo.getUnion(minimap).expanded(2));
+		mControlsLayer.SetBounds(kStatusBarBounds);
+		mIntroWindowLayer.SetBounds({(kGridWidth / 2) - 302, 48, 604, 304});
+		mScoreStatsLayer.SetBounds(kScoreStatsLayerBounds);
+	}
 	
 	// start distance game on launch
 	mDistanceGameStatus = eWaitingForStart;
@@ -1290,16 +1550,45 @@ void TPongView::Init()
 	ObjectHistory::gShipHistory.reserve(kHistorySize);
 	
 	mObjectPool.Init();
-	LoadFilesFromFolder(kImagesFolder, mImages);
-	LoadFilesFromFolder(kGravityImagesFolder, mGravityImages);
+	
+	if (mHeadless)
+	{
+		// a few distinct sizes & colors is enough to exercise the draw path
+		const int32_t kNumColors = 4;
+		const Colour c[kNumColors] = {Colours::orange, Colours::yellow, Colours::blue, Colours::ivory};
+		for (int32_t k = 0; k < 8; k++)
+			mImages.push_back(PlaceholderImage(24 + (8 * (k % 3)), c[k % kNumColors]));
+		for (int32_t k = 0; k < 3; k++)
+			mGravityImages.push_back(PlaceholderImage(48, c[k]));
+	}
+	else
+	{
+		LoadFilesFromFolder(kImagesFolder, mImages);
+		LoadFilesFromFolder(kGravityImagesFolder, mGravityImages);
+	}
 	
 	if (kUseChaserObject)
 	{
-		mChaserImage = ImageFileFormat::loadFrom(File(cChaserImagePath));
+		mChaserImage = this->LoadImage(cChaserImagePath, 24);
 		CMN_ASSERT(mChaserImage.isValid());
 		mNextNewChaserObjectMS = gNowMS + 5000;
 	}
 	
+	// pack the sprites - the objects find theirs as they're created
+	{
+		for (const Image& img : mImages)
+			mSpriteAtlas.Add(&img);
+		for (const Image& img : mGravityImages)
+			mSpriteAtlas.Add(&img);
+		for (const auto& i : mHostageImage)
+			mSpriteAtlas.Add(&i.second);
+		mSpriteAtlas.Add(&mBulletImage);
+		mSpriteAtlas.Add(&mChaserImage);
+		mSpriteAtlas.Build();
+	}
+	
+	mShipTable.BuildSprites();
+	
 	// create ship object
 	{
 		const CVector dummy(0, 0);
@@ -1317,6 +1606,76 @@ void TPongView::Init()
 	
 	if (HasUpperLine())
 		this->NewGroundObject({(double)this->GetGridWidth(), (double)this->GetGridHeight() - 500}, false);
+	
+	// the windowed game takes --stress & --profile too (headless runs set their own)
+	if (!mHeadless)
+	{
+		const StringArray args = JUCEApplication::getCommandLineParameterArray();
+		this->SetStressConfig(StressConfigFromArgs(args));
+		
+		// stress logging reads the frame times
+		mWriteProfile = (args.contains("--profile") || mStressConfig.IsActive());
+		if (mWriteProfile)
+			gProfiler.SetEnabled(true);
+		mShowProfiler = args.contains("--profile");
+		
+		// the pool telemetry's only written if it's asked for - to --pool-csv,
+		// or next to the profile
+		const String poolPath = ArgValue(args, "--pool-csv", "");
+		if (poolPath.isNotEmpty())
+			mPoolCSVFile = File(poolPath);
+		else if (mWriteProfile)
+			mPoolCSVFile = File::getSpecialLocation(File::userDesktopDirectory).getChildFile("SpaceForcePool.csv");
+		
+		// counts for this (the message) thread, which runs the whole frame
+		if (args.contains("--counters"))
+			gProfiler.EnableHardwareCounters();
+		
+		// the flight recorder is always on (it needs the frame times), unless told not to
+		if (!args.contains("--no-flight-recorder"))
+		{
+			gProfiler.SetEnabled(true);
+			mFlightRecorder.reset(new FlightRecorder());
+			const File folder = File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile("SpaceForce");
+			if (!mFlightRecorder->Open(folder, ArgValue(args, "--hitch-ms", String(kRefreshRateMS)).getDoubleValue()))
+				mFlightRecorder.reset();
+		}
+		
+		mGovernor.SetEnabled(!args.contains("--no-governor"));
+		
+		// the timeline is always recording (so 'C' can look back), unless told not to
+		gTraceRecorder.SetEnabled(!args.contains("--no-trace"));
+		gTraceRecorder.SetThreadName("message");
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	~TPongView
+//   - leave the frame profile behind, if it was asked for (the flight
+//     recorder keeps the profiler running in every session, so whether
+//     it has frames doesn't say) - and the pool telemetry, if that was
+/*---------------------------------------------------------------------------*/
+TPongView::~TPongView()
+{
+	if (mHeadless)
+		return;
+	
+	const File desktop = File::getSpecialLocation(File::userDesktopDirectory);
+	if (mWriteProfile && gProfiler.GetNumFrames())
+	{
+		const File csv = desktop.getChildFile("SpaceForceProfile.csv");
+		if (gProfiler.WriteCSV(csv))
+			printf("frame profile written to %s\n", csv.getFullPathName().toRawUTF8());
+	}
+	
+	if (mPoolCSVFile.getFullPathName().isNotEmpty() && mObjectPool.GetTelemetry().WriteCSV(mPoolCSVFile))
+		printf("object pool telemetry written to %s\n", mPoolCSVFile.getFullPathName().toRawUTF8());
+}
+
+/*---------------------------------------------------------------------------*/
+const PoolTelemetry& pong::PoolTelemetryFor(IPongView& view)
+{
+	return static_cast<TPongView&>(view).GetObjectPool().GetTelemetry();
 }
 
 /*---------------------------------------------------------------------------*/
@@ -1326,7 +1685,8 @@ void TPongView::ToggleFlatEarthObject()
 	
 	if (mFlatEarthEnabled)
 	{
-		mFlatEarthImage = ImageFileFormat::loadFrom(File(cFlatEarthImagePath));
+		StTraceScope trace("loadFlatEarthImage");
+		mFlatEarthImage = this->LoadImage(cFlatEarthImagePath, 48);
 		CMN_ASSERT(mFlatEarthImage.isValid());
 		
 		static const CVector p(float(this->GetGridWidth()/2), float(this->GetGridHeight() - 350));
@@ -1359,10 +1719,13 @@ void TPongView::CreateGravityObjects()
 		//const CVector p(rnd(1700, 2400), rnd(-750, -850));
 		static const CVector p(kGridWidth - 100, 60);
 		CObject* blackHole = NewGravityObject(p, rndf(10000,20000));
+		if (!blackHole)
+			return;
+		
 		blackHole->SetFixed(true);
 		
 		static const String deathStar64 = kSpecialImagesFolder + "DeathStar64.png";
-		mBlackHoleImage = ImageFileFormat::loadFrom(File(deathStar64));
+		mBlackHoleImage = this->LoadImage(deathStar64, 64);
 		CMN_ASSERT(mBlackHoleImage.isValid());
 		blackHole->SetImage(&mBlackHoleImage);
 	}
@@ -1378,7 +1741,7 @@ void TPongView::DrawGameOptionRect(std::string text, CVector leftCorner, Graphic
 	g.drawRoundedRectangle(r, 4, 2);
 	
 	//g.setColour(Colours::red);
-	StFontRestorer f(Font(/*"Times",*/ 22, 0), g);
+	StFontRestorer f(mFont22, g);
 	Rectangle<float> textR(leftCorner.mX + 40, leftCorner.mY, 200, 20);
 	g.drawText(text, textR, Justification::left, true);
 }
@@ -1414,43 +1777,245 @@ void TPongView::HandleIntroWindow(Graphics& g)
 	this->DrawGameOptionRect("Alien Shootout", v, g);
 }
 
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DrawLayer
+//   - composite a static layer, re-rendering it first if key has changed
+/*---------------------------------------------------------------------------*/
+template <typename F>
+void TPongView::DrawLayer(CachedLayer& layer, uint64_t key, Graphics& g, F render)
+{
+	const bool rendered = layer.Draw(g, key, [this, &render](Graphics& lg)
+	{
+		mRenderingLayer = true;
+		render(lg);
+		mRenderingLayer = false;
+	});
+	
+	// the HUD's layers are drawn before the clip is taken, so this lands in
+	// this frame's region (the background layers only re-render with the
+	// scene, which repaints everything anyway)
+	if (rendered && mDirtyRectsEnabled)
+		mDirtyRegion.Add(layer.GetBounds());
+}
+
 /*---------------------------------------------------------------------------*/
 // 	METHOD:	Draw
 //  tbarram 5/5/17
 /*---------------------------------------------------------------------------*/
 void TPongView::Draw(Graphics& g)
 {
-	// update the global now
-	gNowMS = Time::getCurrentTime().toMilliseconds();
+	StTraceScope trace("frame");
+	const int64_t frameStart = Time::getHighResolutionTicks();
 	
-	this->CheckKeyPresses();
+	// update the global now - headless runs advance by a fixed step instead
+	const int64_t lastNowMS = gNowMS;
+	gNowMS = (mFixedStepMS ? (gNowMS + mFixedStepMS) : Time::getCurrentTime().toMilliseconds());
+	
+	gProfiler.BeginFrame();
 	
-	pong::DrawImageAt(mGlidePathLogoImage, 86, 16, g);
-
-	// draw minimap outline
-	if (mMinimapActive)
 	{
-		g.drawRect(kMiniMapTopLeftCornerV.mX, kMiniMapTopLeftCornerV.mY, kMinimapWidth, kMinimapHeight, 1);
-		g.drawRect(kMiniMapOuterTopLeftCorner.mX, kMiniMapOuterTopLeftCorner.mY, kMinimapOuterWidth, kMinimapOuterHeight, 1);
+		StPhaseTimer t(ePhaseInput);
+		this->CheckKeyPresses();
 	}
 	
-	this->HandleIntroWindow(g);
-	
-	// calc the new positions, check keypresses, etc.
+	// calc the new positions, check keypresses, etc. (before any drawing, so
+	// the dirty region knows where everything is going to be)
 	this->Animate();
 	
+	// with dirty rects the HUD (and the game logic that goes with it) runs
+	// before the clip is taken, so text & layers that change are in this
+	// frame's region - it's recorded, and played back over the objects below
+	if (mDirtyRectsEnabled)
+	{
+		mHudList.Reset({0, 0, kGridWidth, kGridHeight});
+		Graphics hud(mHudList);
+		hud.setFont(g.getCurrentFont());
+		this->DrawHud(hud);
+	}
+	
+	Graphics::ScopedSaveState state(g);
+	if (mRenderScale != 1.0f)
+		g.addTransform(AffineTransform::scale(mRenderScale));
+	mObjectPool.SetSpriteScale(mRenderScale, (mRenderScale != 1.0f) ? mScaledSprites.GetSet() : nullptr);
+	
+	if (mDirtyRectsEnabled)
+		this->ClipToDirtyRegion(g);
+	
+	this->DrawLayer(mBackgroundLayer, mMinimapActive, g, [this](Graphics& lg)
+	{
+		pong::DrawImageAt(mGlidePathLogoImage, 86, 16, lg);
+		
+		// draw minimap outline
+		if (mMinimapActive)
+		{
+			lg.setColour(Colours::lawngreen);
+			lg.drawRect(kMiniMapTopLeftCornerV.mX, kMiniMapTopLeftCornerV.mY, kMinimapWidth, kMinimapHeight, 1);
+			lg.drawRect(kMiniMapOuterTopLeftCorner.mX, kMiniMapOuterTopLeftCorner.mY, kMinimapOuterWidth, kMinimapOuterHeight, 1);
+		}
+	});
+	
+	if (sGameMode == eStartScreen)
+	{
+		this->DrawLayer(mIntroWindowLayer, 0, g, [this](Graphics& lg)
+		{
+			lg.setColour(Colours::lawngreen);
+			this->HandleIntroWindow(lg);
+		});
+	}
+	
 	// draw all the objects
-	mObjectPool.Draw(g);
+	{
+		StPhaseTimer t(ePhaseDraw);
+		mObjectPool.Draw(g);
+		this->DrawTerrain(g);
+		mParticles.Draw(g);
+	}
 	
 	gHistoryIndex = ((gHistoryIndex + 1) % kHistorySize);
 	
-	this->DrawText(g);
+	if (mDirtyRectsEnabled)
+	{
+		StPhaseTimer t(ePhaseText);
+		LowLevelGraphicsContext& c = g.getInternalContext();
+		c.saveState();
+		for (int32_t k = 0; k < mHudList.GetNumOps(); k++)
+			mHudList.Replay(k, c);
+		c.restoreState();
+	}
+	else
+	{
+		this->DrawHud(g);
+	}
+	
+	gProfiler.EndFrame();
+	mGovernor.EndFrame(TicksToMS(Time::getHighResolutionTicks() - frameStart), this->GetNumActiveObjects());
+	
+	if (mFlightRecorder)
+		this->RecordFlightFrame(gNowMS - lastNowMS);
+	
+	if (mShowProfiler)
+		gProfiler.DrawOverlay(g, kProfilerOverlayBounds, kRefreshRateMS);
+	
+	if (mShowPoolTelemetry)
+		mObjectPool.GetTelemetry().DrawOverlay(g, kPoolOverlayBounds);
+	
+	mTextCache.EndFrame();
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DrawHud
+//   - the text over the objects, and the game modes' logic that draws it
+/*---------------------------------------------------------------------------*/
+void TPongView::DrawHud(Graphics& g)
+{
+	{
+		StPhaseTimer t(ePhaseText);
+		this->DrawText(g);
+	}
+	
 	this->DrawIntroScreens(g);
 	//this->DrawDistanceMeter(g);
-	this->DoDistanceGame(g);
+	
+	{
+		StPhaseTimer t(ePhaseDistanceGame);
+		this->DoDistanceGame(g);
+	}
+	
 	this->DoHostageRescueGame(g);
 }
 
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	ClipToDirtyRegion
+//   - clip to what changed since the last frame & clear it - everything
+//     outside the clip is still in g from the last frame
+/*---------------------------------------------------------------------------*/
+void TPongView::ClipToDirtyRegion(Graphics& g)
+{
+	// anything that rearranges the screen repaints all of it
+	const int64_t scene = ((int64_t)sGameMode << 40) | ((int64_t)mIntroScreen << 32) |
+						  ((int64_t)(mDistanceGameStatus & 0xff) << 24) | ((int64_t)(mHostageGameStatus & 0xff) << 16) |
+						  (mIsPaused << 4) | (this->LevelPause() << 3) | (mMinimapActive << 2) |
+						  (mShowProfiler << 1) | (int64_t)mShowPoolTelemetry;
+	if (scene != mDirtyScene)
+	{
+		mDirtyScene = scene;
+		mDirtyRegion.AddAll();
+	}
+	
+	mObjectPool.AddDirtyBounds(mDirtyRegion);
+	mDirtyRegion.AddTextChanges();
+	
+	// the overlays change every frame
+	if (mShowProfiler)
+		mDirtyRegion.Add(kProfilerOverlayBounds);
+	if (mShowPoolTelemetry)
+		mDirtyRegion.Add(kPoolOverlayBounds);
+	
+	// an empty region leaves nothing to draw into, but the frame still runs
+	g.reduceClipRegion(mDirtyRegion.TakeRectangles());
+	g.fillAll(mBackgroundColour);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DrawTerrain
+//   - each ground line is one path, stroked once
+/*---------------------------------------------------------------------------*/
+void TPongView::DrawTerrain(Graphics& g)
+{
+	g.setColour(Colours::lawngreen);
+	mBottomTerrain.Draw(g, 2.0f);
+	mTopTerrain.Draw(g, 2.0f);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	HudText
+//   - note text drawn at rect, so the dirty region can tell when it changes
+//     (the HUD is drawn before the clip, see Draw)
+/*---------------------------------------------------------------------------*/
+void TPongView::HudText(const CRect& rect, const std::string& text)
+{
+	if (mDirtyRectsEnabled && !mRenderingLayer)
+		mDirtyRegion.AddText(rect, text);
+}
+
+/*---------------------------------------------------------------------------*/
+void TPongView::SetDirtyRectsEnabled(bool enabled, Colour background)
+{
+	mDirtyRectsEnabled = enabled;
+	mBackgroundColour = background;
+	mDirtyRegion.SetBounds(kGridWidth, kGridHeight);
+	mDirtyScene = -1;
+	mObjectPool.SetDirtyRegion(enabled ? &mDirtyRegion : nullptr);
+	mParticles.SetDirtyRegion(enabled ? &mDirtyRegion : nullptr);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	SetRenderScale
+//   - the sprites & layers are re-made for the new scale (the sprites in the
+//     background), and the next frame is repainted in full
+/*---------------------------------------------------------------------------*/
+void TPongView::SetRenderScale(float scale)
+{
+	if (scale == mRenderScale)
+		return;
+	
+	mRenderScale = scale;
+	mScaledSprites.SetScale(mSpriteAtlas, scale);
+	for (CachedLayer* layer : {&mBackgroundLayer, &mControlsLayer, &mIntroWindowLayer, &mScoreStatsLayer})
+		layer->SetScale(scale);
+	
+	mDirtyScene = -1;
+}
+
+/*---------------------------------------------------------------------------*/
+RectangleList<int> TPongView::GetDirtyRectangles()
+{
+	if (!mDirtyRectsEnabled)
+		return RectangleList<int>(CRect(0, 0, kGridWidth, kGridHeight));
+	
+	return mDirtyRegion.GetRectangles();
+}
+
 /*---------------------------------------------------------------------------*/
 void TPongView::DrawDistanceMeter(Graphics& g)
 {
@@ -1483,6 +2048,28 @@ void TPongView::CheckKeyPresses()
 	if (this->CheckKeyPress('p', 100))
 		mIsPaused = !mIsPaused;
 	
+	// C key captures the recent timeline as a chrome trace
+	if (this->CheckKeyPress('c', 1000) && gTraceRecorder.IsEnabled())
+	{
+		const File file = File::getSpecialLocation(File::userDesktopDirectory).getChildFile("SpaceForceTrace.json");
+		gTraceRecorder.WriteJSON(file, kTraceCaptureSeconds);
+	}
+	
+	// O key toggles the object pool overlay
+	if (this->CheckKeyPress('o', 700))
+		mShowPoolTelemetry = !mShowPoolTelemetry;
+	
+	// F key toggles the frame profiler & its overlay
+	if (this->CheckKeyPress('f', 700))
+	{
+		mShowProfiler = !mShowProfiler;
+		if (mShowProfiler)
+		{
+			mWriteProfile = true;
+			gProfiler.SetEnabled(true);
+		}
+	}
+	
 	//if (this->CheckKeyPress('h', 1000))
 	//	ObjectHistory::LogHistory();
 	
@@ -1669,31 +2256,56 @@ void TPongView::DrawText(Graphics& g)
 	{
 		//const int32_t elapsedSec = (int32_t)(gNowMS - gStartTimeMS) / 1000;
 		// draw text box in bottom right corner  GetNumActiveObjects
-		const int32_t margin = 50;
-		const CRect rect(margin, this->GetGridHeight() - 80, this->GetGridWidth() - (2 * margin), 30); // x,y,w,h
-		const std::string textL =
+		const CRect& rect = kStatusBarBounds;
+		
+		// the object count changes nearly every frame, so it's only sampled a
+		// couple of times a second - otherwise the text (& its cached layout)
+		// would be rebuilt every frame
+		const int64_t kStatusObjectsMS = 500;
+		if ((gNowMS - mStatusObjectsMS) >= kStatusObjectsMS || gNowMS < mStatusObjectsMS)
+		{
+			mStatusObjects = mObjectPool.GetNumActiveObjects();
+			mStatusObjectsMS = gNowMS;
+		}
+		
+		// only rebuilt when something in it changes
+		const uint64_t key = LayerKey().Add(mLevel).Add(mShipObject->GetNumHitPoints())
+									   .Add(mStatusObjects).Add(mSongName).Get();
+		if (key != mStatusTextKey || mStatusText.empty())
+		{
+			mStatusTextKey = key;
+			mStatusText =
 				"\nlevel: " + std::to_string(mLevel) +
 				//"\t\tkills: " + std::to_string(mKills) +
 				//"\t\tdeaths: " + std::to_string(mDeaths) +
 				"\t\thp: " +	std::to_string(mShipObject->GetNumHitPoints()) +
 				//"\t\tbombs: " + std::to_string(mNumSmartBombs) +
 				//"\t\ttime: " + std::to_string(elapsedSec) + " sec" +
-				"\t\tobjects: " + std::to_string(mObjectPool.GetNumActiveObjects()) +
+				"\t\tobjects: " + std::to_string(mStatusObjects) +
 				"\t\tsong: " + mSongName.substr(0,32); // +
 				//"\t\tgame: " + mDistanceGameString;
-		
-		const std::string textR =
-				std::string("\n\t\t thrust: Z") +
-				"\t\t  rotate: L/R arrows" +
-				"\t\t shoot: X" +
-				//"\t\t bomb: S" +
-				"\t\t reset: R" +
-				"\t\t skip song: M" +
-				"\t\t continue: K";
+		}
+		const std::string& textL = mStatusText;
 		
 		g.setColour(Colours::honeydew);
-		g.drawFittedText(textL, rect, Justification::left, true);
-		g.drawFittedText(textR, rect, Justification::right, true);
+		mTextCache.DrawFittedText(g, textL, g.getCurrentFont(), rect, Justification::left, 1);
+		this->HudText(rect, textL);
+		
+		// the controls never change
+		this->DrawLayer(mControlsLayer, 0, g, [&rect](Graphics& lg)
+		{
+			const std::string textR =
+					std::string("\n\t\t thrust: Z") +
+					"\t\t  rotate: L/R arrows" +
+					"\t\t shoot: X" +
+					//"\t\t bomb: S" +
+					"\t\t reset: R" +
+					"\t\t skip song: M" +
+					"\t\t continue: K";
+			
+			lg.setColour(Colours::honeydew);
+			lg.drawFittedText(textR, rect, Justification::right, true);
+		});
 	}
 	
 	// show level text
@@ -1702,7 +2314,8 @@ void TPongView::DrawText(Graphics& g)
 		CRect rect(0, 0, this->GetGridWidth(), 400); // x,y,w,h
 		const std::string text = "LEVEL " + std::to_string(mLevel);
 		g.setColour(Colours::lawngreen);
-		g.drawText(text, rect, Justification::centred, true);
+		mTextCache.DrawText(g, text, g.getCurrentFont(), rect, Justification::centred);
+		this->HudText(rect, text);
 	}
 }
 
@@ -1730,7 +2343,7 @@ void TPongView::DoExplosions()
 /*---------------------------------------------------------------------------*/
 bool TPongView::CheckKeyPress(char key, int32_t throttleMS)
 {
-	if (KeyPress::isKeyCurrentlyDown(key) &&
+	if (IsKeyDown(key) &&
 		((gNowMS - mLastKeyPressTimeMS[key]) > throttleMS))
 	{
 		mLastKeyPressTimeMS[key] = gNowMS;
@@ -1768,26 +2381,51 @@ void TPongView::Animate()
 	if (mIsPaused)
 		return;
 	
-	// see if it's time for the next level
-	this->UpdateLevel();
-	
-	// see if it's time to create new objects
-	if (!this->LevelPause())
-		this->CreateNewObjects();
+	{
+		StPhaseTimer t(ePhaseUpdateLevel);
+		
+		// see if it's time for the next level
+		this->UpdateLevel();
+		
+		// see if it's time to create new objects
+		if (!this->LevelPause())
+			this->CreateNewObjects();
+		
+		this->UpdateStress(diffSec);
+	}
 	
 	// animate all the objects
-	mObjectPool.Animate(diffSec);
+	{
+		StPhaseTimer t(ePhaseAnimate);
+		mObjectPool.Animate(diffSec);
+		mParticles.Animate((float)diffSec, gNowMS, kGridWidth, kGridHeight);
+		
+		// the same distance the ground segments just moved
+		mBottomTerrain.Scroll(-kGroundSpeedBottom * diffSec);
+		mTopTerrain.Scroll(-kGroundSpeedTop * diffSec);
+	}
+	
+	{
+		StPhaseTimer t(ePhaseGravity);
+		mObjectPool.ResetGravityAcc();
+	}
+	
+	{
+		StPhaseTimer t(ePhaseInteractions);
+		mObjectPool.HandleObjectPairInteractions();
+	}
 	
-	mObjectPool.ResetGravityAcc();
-	mObjectPool.HandleObjectPairInteractions();
-	mObjectPool.CheckVerticalBounds();
+	{
+		StPhaseTimer t(ePhaseVerticalBounds);
+		mObjectPool.CheckVerticalBounds();
+	}
 	
 	// shoot
 	if (this->CheckKeyPress('x', 0))
 		this->ShootBullets();
 	
 	// smart bomb
-	if (KeyPress::isKeyCurrentlyDown('s') || mAutoSmartBombMode)
+	if (IsKeyDown('s') || mAutoSmartBombMode)
 		this->SmartBomb();
 	
 	// see if we should dock
@@ -1818,6 +2456,29 @@ void TPongView::Animate()
 		this->SetShipSafe(2000);
 }
 
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	SetGameMode
+//   - jump straight into a mode, for headless runs (normally done via the keys)
+/*---------------------------------------------------------------------------*/
+void TPongView::SetGameMode(GameMode mode)
+{
+	const bool hadUpperLine = HasUpperLine();
+	sGameMode = mode;
+	
+	mShipObject->SetMass(0);
+	mShipObject->ShipReset();
+	mObjectPool.DestroyAllGravityObjects();
+	
+	mDistanceGameStatus = (mode == eDistanceGame ? eWaitingForStart : eInactive);
+	mHostageGameStatus = (mode == eHostageRescue ? eWaitingForStart : eInactive);
+	
+	if (mode == eGravityShepherd)
+		this->CreateGravityObjects();
+	
+	if (HasUpperLine() && !hadUpperLine)
+		this->NewGroundObject({(double)this->GetGridWidth(), (double)this->GetGridHeight() - 500}, false);
+}
+
 /*---------------------------------------------------------------------------*/
 void TPongView::SetShipSafe(int64_t lengthMS)
 {
@@ -1830,14 +2491,16 @@ void TPongView::SetShipSafe(int64_t lengthMS)
 void TPongView::DrawTextAtY(std::string text, int32_t y, Graphics& g)
 {
 	CRect rect(0, y, this->GetGridWidth(), 20); // x,y,w,h
-	g.drawText(text, rect, Justification::centred, true);
+	mTextCache.DrawText(g, text, g.getCurrentFont(), rect, Justification::centred);
+	this->HudText(rect, text);
 }
 
 /*---------------------------------------------------------------------------*/
 void TPongView::DrawTextAtXY(std::string text, int32_t x, int32_t y, Graphics& g)
 {
 	CRect rect(x, y, 360, 20); // x,y,w,h
-	g.drawText(text, rect, Justification::right, true);
+	mTextCache.DrawText(g, text, g.getCurrentFont(), rect, Justification::right);
+	this->HudText(rect, text);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -2084,7 +2747,7 @@ void TPongView::RescuedHostage(EHostageType type)
 // not used anymore - replaced with live values in ShowScoreStats()
 void TPongView::DrawHostageGameLegend(Graphics& g)
 {
-	StFontRestorer f(22, g);
+	StFontRestorer f(mFont22, g);
 	g.setColour(Colours::orange);
 	
 	static const CVector pos(this->GetGridWidth() - 400, 100);
@@ -2117,14 +2780,35 @@ void TPongView::ShowScoreStats(Graphics& g)
 	if (sGameMode != eHostageRescue && sGameMode != eDistanceGame)
 		return;
 	
-	StFontRestorer f(14, g);
+	StFontRestorer f(mFont14, g);
 	g.setColour(Colours::lawngreen);
 	const int32_t x = this->GetGridWidth() - 400;
-	int32_t y = 10;
 	
 	const std::string stage = (mDistanceGameStatus == eWaitingForStart ? "Last" : "Current");
-	DrawTextAtXY("--- " + stage + " score: " + std::to_string(mNewDistanceGameScore) + " ---", x, y, g);
-	y += 16;
+	DrawTextAtXY("--- " + stage + " score: " + std::to_string(mNewDistanceGameScore) + " ---", x, 10, g);
+	
+	// the rest only changes on score events
+	LayerKey key;
+	key.Add(sGameMode).Add(mNewDistanceGameScoreBest).Add(mNewDistanceGameScoreBestAllTime);
+	for (const ScoreEventMap* map : {&sScoreEventCounter, &sBestScoreEventCounter, &sBestAllTimeScoreEventCounter})
+	{
+		key.Add((int64_t)map->size());
+		for (const auto& i : *map)
+			key.Add(i.first).Add(i.second);
+	}
+	
+	this->DrawLayer(mScoreStatsLayer, key.Get(), g, [this](Graphics& lg) { this->RenderScoreStats(lg); });
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RenderScoreStats
+//   - everything under ShowScoreStats' first line
+/*---------------------------------------------------------------------------*/
+void TPongView::RenderScoreStats(Graphics& g)
+{
+	StFontRestorer f(mFont14, g);
+	const int32_t x = this->GetGridWidth() - 400;
+	int32_t y = kScoreStatsLayerBounds.getY();
 	
 	ScoreStatsUI(sScoreEventCounter, x, y, g);
 	
@@ -2161,7 +2845,7 @@ void TPongView::DoHostageRescueGame(Graphics& g)
 	//if (mHostageGameStatus != eInactive)
 		//this->DrawHostageGameLegend(g);
 	
-	StFontRestorer f(22, g);
+	StFontRestorer f(mFont22, g);
 	g.setColour(Colours::floralwhite);
 	
 	switch (mHostageGameStatus)
@@ -2232,8 +2916,7 @@ void TPongView::DoDistanceGame(Graphics& g)
 	gSlidingAverage.AddSample(mShipDistanceToGround);
 	g.setColour(Colours::honeydew);
 	
-	StFontRestorer f(26, g);
-	g.setFont(Font("Chalkboard", 28, 0));
+	StFontRestorer f(mChalkboardFont, g);
 	
 	switch (mDistanceGameStatus)
 	{
@@ -2492,10 +3175,11 @@ CObject* TPongView::NewObject(const EObjectType type, const CState state, bool m
 {
 	CObject* obj = mObjectPool.NewObject(this, type, state);
 	
-	if (mMinimapActive && minimap)
+	if (obj && mMinimapActive && minimap && !mGovernor.Sheds(eQualityNoMinimap))
 	{
 		CObject* miniMapObj = this->NewObject(eMiniMap, {{0,0}, {0,0}, {0,0}, 0, 0});
-		miniMapObj->SetParent(obj);
+		if (miniMapObj)
+			miniMapObj->SetParent(obj);
 	}
 	
 	return obj;
@@ -2507,8 +3191,16 @@ void TPongView::NewTextBubble(std::string text, CVector pos, Colour color)
 	static const CVector v(-20, -50);
 	static const CVector a(20, -20);
 	static const int64_t lifetime = 3000;
-	CObject* obj = this->NewObject(eTextBubble, {pos, v, a, lifetime, 0});
-	obj->SetTextBubbleText(text);
+	
+	if (mGovernor.Sheds(eQualityFewerTextBubbles) &&
+		mObjectPool.GetTelemetry().GetTypeStats(ObjectTypeIndex(eTextBubble)).mLive >= QualityGovernor::kMaxTextBubbles)
+		return;
+	
+	CObject* obj = this->NewObject(eTextBubble, {pos, v, a, lifetime, 0});
+	if (!obj)
+		return;
+	
+	obj->SetTextBubbleText(text);
 	obj->SetColor(color);
 }
 
@@ -2517,6 +3209,9 @@ CObject* TPongView::NewGravityObject(CVector pos, double mass)
 {
 	static const int32_t killedBy = eBullet;
 	CObject* obj = this->NewObject(eGravity, {pos, zero, zero, 0, killedBy}, true);
+	if (!obj)
+		return nullptr;
+	
 	obj->SetMass(mass);
 	
 	CMN_ASSERT(mGravityImages.size() > 0);
@@ -2531,12 +3226,18 @@ void TPongView::NewGroundObject(CVector pos, bool isBottom)
 {
 	const CVector v(isBottom ? -kGroundSpeedBottom : -kGroundSpeedTop, 0);
 	CObject* groundObject = this->NewObject(eGround, {pos, v, zero, 0, 0});
+	if (!groundObject)
+		return;
+	
 	this->GetObjectPool().AddGroundObject(groundObject);
 	
 	const bool hostagesInDistanceGame = false; //(mPongView->DistanceGameActive() && !isBottom);
 	
 	groundObject->InitGround(isBottom);
 	
+	const CVector right = groundObject->GroundRightEndpoint();
+	this->Terrain(isBottom).Append({pos.mX, pos.mY}, {right.mX, right.mY});
+	
 	// add a hostage
 	if ((HostageRescueGameActive() || hostagesInDistanceGame)
 		&& CheckDeadline(mNextHostageObjectMS))
@@ -2544,6 +3245,9 @@ void TPongView::NewGroundObject(CVector pos, bool isBottom)
 		mNextHostageObjectMS = 0;
 		// create hostage object attached to this ground object
 		CObject* hostage = this->NewObject(eHostage, {zero, zero, zero, 0, eShip});
+		if (!hostage)
+			return;
+		
 		hostage->SetGroundObjectForHostage(groundObject);
 		
 		const int32_t rand = rnd(10);
@@ -2671,6 +3375,127 @@ void TPongView::ShootBullets()
 	}
 }
 
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	ShootBulletFan
+//   - bullets evenly spaced all the way around the ship (stress mode)
+/*---------------------------------------------------------------------------*/
+void TPongView::ShootBulletFan(int32_t numBullets)
+{
+	static const double speed = 400.0;
+	const double angleInc = (2 * M_PI / numBullets);
+	
+	for (int32_t k = 0; k < numBullets; k++)
+	{
+		const pong::CVector v = pong::CVector::Velocity(speed, mShipObject->GetAngle() + (k * angleInc));
+		this->ShootBullet(mShipObject->GetFront(), v);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void TPongView::SetStressConfig(const StressConfig& config)
+{
+	mStressConfig = config;
+	mStressStartMS = gNowMS;
+	mStressNextLogMS = gNowMS;
+	mStressExplosions = mStressBulletFans = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	UpdateStress
+//   - top up each stress population to its (ramping) target, and log the
+//     frame time against the live object count once a second
+/*---------------------------------------------------------------------------*/
+void TPongView::UpdateStress(double diffSec)
+{
+	if (!mStressConfig.IsActive())
+		return;
+	
+	// leave some room in the pool for the game itself (ground, text, bullets)
+	static const int32_t kPoolHeadroom = 64;
+	auto poolHasRoom = [this]() { return mObjectPool.GetNumFreeSlots() > kPoolHeadroom; };
+	
+	const StressConfig& c = mStressConfig;
+	const int64_t elapsedMS = (gNowMS - mStressStartMS);
+	const double ramp = (c.mRampMS > 0 ? std::min(1.0, (double)elapsedMS / c.mRampMS) : 1.0);
+	
+	const int32_t numIcons = (int32_t)(ramp * c.mNumIcons);
+	for (int32_t k = mObjectPool.CountObjectsOfType(eIcon); k < numIcons && poolHasRoom(); k++)
+	{
+		if (k % 2)
+			this->NewCrawlingIconObject();
+		else
+			this->NewFallingIconObject();
+	}
+	
+	const int32_t numVectors = (int32_t)(ramp * c.mNumVectors);
+	for (int32_t k = mObjectPool.CountObjectsOfType(eVector); k < numVectors && poolHasRoom(); k++)
+		this->NewVectorIconObject();
+	
+	const int32_t numGravity = (int32_t)(ramp * c.mNumGravity);
+	for (int32_t k = mObjectPool.CountObjectsOfType(eGravity); k < numGravity && poolHasRoom(); k++)
+		this->NewGravityObject({rndf(100, kGridWidth - 100), rndf(100, kGridHeight - 200)}, rndf(10, 20));
+	
+	mStressExplosions += (ramp * c.mExplosionsPerSec * diffSec);
+	// the fragments are particles, so explosions don't need the pool
+	for (; mStressExplosions >= 1; mStressExplosions--)
+		this->Explosion({rndf(0, kGridWidth), rndf(0, kGridHeight - 100)});
+	
+	mStressBulletFans += (ramp * c.mBulletFansPerSec * diffSec);
+	for (; mStressBulletFans >= 1; mStressBulletFans--)
+	{
+		if (poolHasRoom())
+			this->ShootBulletFan(c.mBulletsPerFan);
+	}
+	
+	// headless runs collect their own per-frame numbers
+	if (!mHeadless && gNowMS >= mStressNextLogMS)
+	{
+		mStressNextLogMS = (gNowMS + 1000);
+		printf("stress: %6.1f sec  ramp %3d%%  objects %4d  particles %5d  frame %6.2f ms (animate %.2f, interactions %.2f, draw %.2f)\n",
+			   elapsedMS / 1000.0, (int32_t)(ramp * 100), mObjectPool.GetNumActiveObjects(), mParticles.GetNumParticles(),
+			   gProfiler.GetLastFrameMS(), gProfiler.GetLastPhaseMS(ePhaseAnimate),
+			   gProfiler.GetLastPhaseMS(ePhaseInteractions), gProfiler.GetLastPhaseMS(ePhaseDraw));
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RecordFlightFrame
+//   - the frame that just finished, for the flight recorder
+/*---------------------------------------------------------------------------*/
+void TPongView::RecordFlightFrame(int64_t intervalMS)
+{
+	FlightRecord r;
+	r.mFrame = (uint64_t)gProfiler.GetNumFrames();
+	r.mNowMS = gNowMS;
+	r.mIntervalMS = (float)intervalMS;
+	r.mFrameMS = (float)gProfiler.GetLastFrameMS();
+	for (int32_t k = 0; k < eNumProfilePhases; k++)
+		r.mPhaseMS[k] = (float)gProfiler.GetLastPhaseMS((ProfilePhase)k);
+	
+	for (int32_t t = 0; t < kNumObjectTypes; t++)
+		r.mObjects[t] = (uint16_t)mObjectPool.GetTelemetry().GetTypeStats(t).mLive;
+	
+	// the fragments (ship ones too) are particles, not pool objects
+	r.mObjects[ObjectTypeIndex(eFragment)] = (uint16_t)mParticles.GetNumParticles();
+	
+	r.mInputs = 0;
+	if (IsKeyDown('z') || IsKeyDown('w') || IsKeyDown(KeyPress::upKey))
+		r.mInputs |= eInputThrust;
+	if (IsKeyDown('a') || IsKeyDown(KeyPress::leftKey))
+		r.mInputs |= eInputLeft;
+	if (IsKeyDown('d') || IsKeyDown(KeyPress::rightKey))
+		r.mInputs |= eInputRight;
+	if (IsKeyDown('x'))
+		r.mInputs |= eInputShoot;
+	if (IsKeyDown('s'))
+		r.mInputs |= eInputBomb;
+	
+	r.mGameMode = (int8_t)sGameMode;
+	r.mDistanceGameStatus = (int8_t)mDistanceGameStatus;
+	
+	mFlightRecorder->Record(r);
+}
+
 /*---------------------------------------------------------------------------*/
 // 	METHOD:	SmartBomb
 /*---------------------------------------------------------------------------*/
@@ -2854,6 +3679,9 @@ void CObject::Died()
 	if (this->Is(eVector))
 		mPongView->VectorObjectDied();
 	
+	if (this->Is(eGround))
+		mPongView->GroundObjectDied(mIsBottom);
+	
 	if (this->Is(eChaser))
 		mPongView->ChaserObjectDied();
 	
@@ -2863,11 +3691,12 @@ void CObject::Died()
 
 /*---------------------------------------------------------------------------*/
 // 	METHOD:	Explode
-//   - send a bunch of fragments off from the passed-in position
+//   - send a bunch of fragments off from the passed-in position (they're
+//     particles, not objects - see ParticleSystem.h)
 /*---------------------------------------------------------------------------*/
 void TPongView::Explosion(const CVector& pos, bool isShip)
 {
-	const int32_t kNumFrags = isShip ? 22 : rnd(6, 12);
+	const int32_t kNumFrags = mGovernor.ScaleFragments(isShip ? 22 : rnd(6, 12));
 	const double kAngleInc = 2 * M_PI / kNumFrags;
 	
 	for (int32_t j = 0; j < kNumFrags; j++)
@@ -2890,7 +3719,12 @@ void TPongView::Explosion(const CVector& pos, bool isShip)
 		// give each fragment a random expiration time
 		const int32_t lifetime = (isShip ? 4000 : 2000) + (300 * (rnd(kNumFrags)));
 		
-		this->NewObject(isShip ? eShipFragment : eFragment, {pos, v, a, lifetime, 0});
+		// and a random color & size
+		const int32_t colour = rnd(isShip ? ParticleSystem::kNumColours : ParticleSystem::kNumFragmentColours);
+		const float size = (float)rnd(2, 6);
+		
+		mParticles.Add({(float)pos.mX, (float)pos.mY, (float)v.mX, (float)v.mY, (float)a.mX, (float)a.mY,
+						gNowMS + lifetime, colour, size});
 	}
 }
 
@@ -2957,8 +3791,9 @@ void CObject::CalcPosition(const double diffSec)
 		// calc previous position rects for bullet collisions - we need these so
 		// the bullets don't pass through objects due to low frame rate -
 		// i.e. CCD (Continuous Collision Detection)
-		const double diffSecInc = diffSec / (double)kNumBulletCollisionRects;
-		for (int32_t k = 0; k < kNumBulletCollisionRects; k++)
+		mNumBulletCollisionRects = mPongView->GetQualityGovernor().ScaleBulletCollisionRects(kNumBulletCollisionRects);
+		const double diffSecInc = diffSec / (double)mNumBulletCollisionRects;
+		for (int32_t k = 0; k < mNumBulletCollisionRects; k++)
 		{
 			const double inc = diffSecInc * k;
 			const double v = mState.mPos.mY + (mState.mVel.mY * inc);
@@ -3021,7 +3856,7 @@ bool CObject::CollidedWith(CObject& other)
 		CObject* bullet = this->Is(eBullet) ? this : &other;
 		CObject* nonBullet = this->Is(eBullet) ? &other : this;
 		
-		for (int32_t k = 0; k < kNumBulletCollisionRects; k++)
+		for (int32_t k = 0; k < bullet->mNumBulletCollisionRects; k++)
 			if (this->CollidedWith(bullet->mBulletCollisionRects[k], nonBullet->mCollisionRect))
 				return true;
 		
@@ -3165,25 +4000,6 @@ void CObject::Collided(ECollisionType type)
 	}
 }
 
-/*---------------------------------------------------------------------------*/
-// 	METHOD:	Rotate
-//  - rotate point p around a center point c based on the ship's angle
-/*---------------------------------------------------------------------------*/
-void CObject::Rotate(CPointF& p, const CPointF& c)
-{
-	// normalize
-	p.x -= c.x;
-	p.y -= c.y;
-
-	// rotate
-	const double h = (p.x * mAngleCos - p.y * mAngleSin);
-	const double v = (p.x * mAngleSin + p.y * mAngleCos);
-
-	// un-normalize
-	p.x = (h + c.x);
-	p.y = (v + c.y);
-}
-
 /*---------------------------------------------------------------------------*/
 void CObject::GetPredefinedShipData()
 {
@@ -3192,8 +4008,8 @@ void CObject::GetPredefinedShipData()
 	mState.mPos.mX = h.mX;
 	mState.mPos.mY = h.mY;
 	mAngle = h.mAngle;
-	mAngleSin = ::sin(mAngle);
-	mAngleCos = ::cos(mAngle);
+	mAngleSin = mPongView->GetShipTable().Get(mAngle).mSin;
+	mAngleCos = mPongView->GetShipTable().Get(mAngle).mCos;
 	mThrusting = (h.mThrusting == 1);
 }
 
@@ -3208,57 +4024,29 @@ void CObject::AnimateShip()
 	if (kFreezeShipInMiddle)
 		mState.mPos = {600, 400};
 	
-	// position refers to the center of the triangle
-	const CPointF pos(mState.mPos.mX, mState.mPos.mY);
-	
-	static const int32_t kBaseWidth = 16;
-	static const int32_t kHeight = 8;
-	static const int32_t kHalfBaseWidth = (kBaseWidth / 2);
-	static const int32_t kHalfHeight = kHeight / 2;
-	static const int32_t kCenterIndent = 4;
-	static const int32_t kThrustWidth = ((kBaseWidth / 4) - 1);
-	static const int32_t kThrustHeight = 8;
-	
-	// the ship has 4 vertices
-	std::list<CPointF> ship;
-	ship.push_back(CPointF(pos.x - kHalfBaseWidth, pos.y + kHalfHeight)); // bottomL
-	ship.push_back(CPointF(pos.x, pos.y + kHalfHeight - kCenterIndent)); // bottomC
-	ship.push_back(CPointF(pos.x + kHalfBaseWidth, pos.y + kHalfHeight)); // bottomR
-	ship.push_back(CPointF(pos.x, pos.y - kHalfHeight));	// top
+	// position refers to the center of the triangle - the rest is the
+	// rotated ship for this angle, from the table
+	const double x = mState.mPos.mX, y = mState.mPos.mY;
+	mOrientation = &mPongView->GetShipTable().Get(mAngle);
+	const ShipOrientation& o = *mOrientation;
 	
 	// mVertices is used for drawing and for collision-with-ground detection
 	mVertices.clear();
-	mVertices.reserve(ship.size());
-	
-	// rotate each point and add to mVertices
-	for (auto& pt : ship)
-	{
-		this->Rotate(pt, pos);
-		mVertices.push_back({(int32_t)pt.x, (int32_t)pt.y});
-	}
+	for (const auto& v : o.mVertices)
+		mVertices.push_back({(int32_t)(x + v.x), (int32_t)(y + v.y)});
 	
-	mCollisionRect = CRect::findAreaContainingPoints((CPointI*)(&mVertices[0]), (int32_t)mVertices.size());
+	// the same as the area containing mVertices, since truncating doesn't change their order
+	const int32_t left = (int32_t)(x + o.mMin.x), top = (int32_t)(y + o.mMin.y);
+	mCollisionRect = CRect(left, top, (int32_t)(x + o.mMax.x) - left, (int32_t)(y + o.mMax.y) - top);
 	
 	// cache mFront for bullet origin
-	mFront = CPointF(pos.x, pos.y - kHalfHeight);
-	this->Rotate(mFront, pos);
+	mFront = CPointF((float)(x + o.mFront.x), (float)(y + o.mFront.y));
 
 	mThrustVertices.clear();
 	if (mThrusting)
 	{
-		std::list<CPointF> thrust;
-		thrust.push_back(CPointF(pos.x - kThrustWidth, pos.y + kHalfHeight)); // bottomL
-		thrust.push_back(CPointF(pos.x, pos.y + kHalfHeight + kThrustHeight)); // bottomC
-		thrust.push_back(CPointF(pos.x + kThrustWidth, pos.y + kHalfHeight)); // bottomR
-		
-		mThrustVertices.reserve(thrust.size());
-		
-		// rotate each point and add to mThrustVertices
-		for (auto& pt : thrust)
-		{
-			this->Rotate(pt, pos);
-			mThrustVertices.push_back({(int)pt.x, (int)pt.y});
-		}
+		for (const auto& v : o.mThrust)
+			mThrustVertices.push_back({(int32_t)(x + v.x), (int32_t)(y + v.y)});
 	}
 	
 	mPongView->AddChaserPosition(mState.mPos);
@@ -3306,25 +4094,31 @@ void CObject::DrawShip(Graphics& g)
 			blinkEndMS = 0;
 	}
 	
+	if (!mOrientation)
+		return;
+	
+	// the pre-filled shapes for this angle, in the current colour - scaled
+	// up they'd blur, so then the same vertices are filled as paths
+	const int32_t x = (int32_t)mState.mPos.mX - ShipTable::kSpriteOrigin;
+	const int32_t y = (int32_t)mState.mPos.mY - ShipTable::kSpriteOrigin;
+	const bool scaled = (mPongView->GetRenderScale() != 1.0f);
+	const AffineTransform toPos = AffineTransform::translation((float)(x + ShipTable::kSpriteOrigin), (float)(y + ShipTable::kSpriteOrigin));
+	
 	// draw ship
-	{
-		auto& v = mVertices;
-		Path p;
-		p.startNewSubPath(CPointF(v[0].x, v[0].y));
-		for (int k = 1; k <= 3; k++)
-			p.lineTo(CPointF(v[k].x, v[k].y));
-		p.closeSubPath();
-		g.fillPath(p);
-	}
+	if (scaled)
+		g.fillPath(ShipTable::ShapePath(mOrientation->mVertices, ShipOrientation::kNumVertices), toPos);
+	else
+		g.drawImageAt(mOrientation->mShipMask, x, y, true);
 	
 	// draw thrust
 	auto& tv = mThrustVertices;
 	if (tv.size() > 0 && tv[0].x != 0 && tv[0].x != -1)
 	{
-		Path p;
 		g.setColour(Colours::red);
-		p.addTriangle(tv[0].x, tv[0].y, tv[1].x, tv[1].y, tv[2].x, tv[2].y);
-		g.fillPath(p);
+		if (scaled)
+			g.fillPath(ShipTable::ShapePath(mOrientation->mThrust, ShipOrientation::kNumThrustVertices), toPos);
+		else
+			g.drawImageAt(mOrientation->mThrustMask, x, y, true);
 	}
 }
 
@@ -3381,15 +4175,15 @@ void CObject::GetControlData()
 {
 	bool isRotating = false;
 	
-	if (KeyPress::isKeyCurrentlyDown(KeyPress::rightKey) ||
-		KeyPress::isKeyCurrentlyDown('d'))
+	if (IsKeyDown(KeyPress::rightKey) ||
+		IsKeyDown('d'))
 	{
 		mAngle += kRotateSpeed;
 		isRotating = true;
 	}
 	
-	if (KeyPress::isKeyCurrentlyDown(KeyPress::leftKey) ||
-		KeyPress::isKeyCurrentlyDown('a'))
+	if (IsKeyDown(KeyPress::leftKey) ||
+		IsKeyDown('a'))
 	{
 		mAngle -= kRotateSpeed;
 		isRotating = true;
@@ -3407,9 +4201,9 @@ void CObject::GetControlData()
 	if (::fabs(mAngle) < 0.0001)
 		mAngle = 0.0;
 	
-	// calc and cache sin & cos
-	mAngleSin = ::sin(mAngle);
-	mAngleCos = ::cos(mAngle);
+	// look up and cache sin & cos
+	mAngleSin = mPongView->GetShipTable().Get(mAngle).mSin;
+	mAngleCos = mPongView->GetShipTable().Get(mAngle).mCos;
 	
 	const bool onlyVerticalThrust = false;
 	
@@ -3417,9 +4211,9 @@ void CObject::GetControlData()
 	
 	mThrusting = false;
 	if (mThrustEnabled && !hasBeenRotatingABit &&
-		(KeyPress::isKeyCurrentlyDown('z') ||
-		 KeyPress::isKeyCurrentlyDown('w') ||
-		 KeyPress::isKeyCurrentlyDown(KeyPress::upKey)))
+		(IsKeyDown('z') ||
+		 IsKeyDown('w') ||
+		 IsKeyDown(KeyPress::upKey)))
 	{
 		// un-lock from earth when thrust happens after the initial wait
 		if (this->IsDockedToEarth() && gNowMS > mDockedToEarthMS)
@@ -3452,18 +4246,15 @@ void CObject::LineBetween(Graphics& g, CVector p1, CVector p2, int32_t size)
 }
 
 /*---------------------------------------------------------------------------*/
-// 	METHOD:	DrawGroundObject
-//   - draw one segment of the ground
+// 	METHOD:	UpdateGroundObject
+//   - one segment of the ground, once per frame - the line itself is drawn
+//     for all the segments at once by TPongView::DrawTerrain
 /*---------------------------------------------------------------------------*/
-void CObject::DrawGroundObject(Graphics& g)
+void CObject::UpdateGroundObject()
 {
-	g.setColour(Colours::lawngreen);
-	
 	// the position of the line segment is defined as its left endpoint
 	mLeftEndpoint = mState.mPos;
-	mRightEndpoint = {mLeftEndpoint.mX + mWidth, mLeftEndpoint.mY + mHeight};
-	
-	this->LineBetween(g, mLeftEndpoint, mRightEndpoint);
+	mRightEndpoint = this->GroundRightEndpoint();
 	
 	// draw the ground in the minimap
 	//CVector miniMapL = TranslateForMinimap(mLeftEndpoint);
@@ -3485,10 +4276,58 @@ void CObject::DrawGroundObject(Graphics& g)
 /*---------------------------------------------------------------------------*/
 void CObject::DrawTextBubble(Graphics& g)
 {
-	StFontRestorer r({"helvetica", 18, 0}, g);
 	g.setColour(mColor);
 	CRect rect(mState.mPos.mX, mState.mPos.mY, mWidth, mHeight); // x,y,w,h
-	g.drawText(mTextBubbleText, rect, Justification::left, true);
+	mPongView->GetTextCache().DrawText(g, mTextBubbleText, mPongView->GetTextBubbleFont(), rect, Justification::left);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DrawBounds
+//   - everything Draw() will touch (given the current state), with some slack
+/*---------------------------------------------------------------------------*/
+CRect CObject::DrawBounds() const
+{
+	Rectangle<float> r;
+	if (this->Is(eShip))
+	{
+		if (mVertices.size() < 4)
+			return CRect();
+		
+		float minX = mVertices[0].x, maxX = minX, minY = mVertices[0].y, maxY = minY;
+		auto addPoint = [&](const CPointI& p)
+		{
+			minX = std::min(minX, (float)p.x); maxX = std::max(maxX, (float)p.x);
+			minY = std::min(minY, (float)p.y); maxY = std::max(maxY, (float)p.y);
+		};
+		
+		for (int k = 1; k <= 3; k++)
+			addPoint(mVertices[k]);
+		
+		// same test as DrawShip
+		const auto& tv = mThrustVertices;
+		if (tv.size() > 0 && tv[0].x != 0 && tv[0].x != -1)
+		{
+			for (const CPointI& p : tv)
+				addPoint(p);
+		}
+		
+		r = {minX, minY, maxX - minX, maxY - minY};
+	}
+	else if (this->Is(eGround))
+	{
+		// the segment from mState.mPos to (+mWidth, +mHeight), either way up
+		const float x = (float)mState.mPos.mX, y = (float)mState.mPos.mY;
+		r = {std::min(x, x + mWidth), std::min(y, y + mHeight), (float)std::abs(mWidth), (float)std::abs(mHeight)};
+	}
+	else
+	{
+		r = {(float)mState.mPos.mX, (float)mState.mPos.mY, (float)mWidth, (float)mHeight};
+	}
+	
+	if (kDrawCollisionRectOutline && !this->Is(eGround))
+		r = r.getUnion(mCollisionRect.toFloat());
+	
+	return r.getSmallestIntegerContainer().expanded(kDirtyMargin);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -3496,6 +4335,7 @@ void CObject::SetImage(Image* img)
 {
 	CMN_ASSERT(img->isValid());
 	mImage = img;
+	mSprite = mPongView->GetSpriteAtlas().Find(img);
 	mWidth = mImage->getWidth();
 	mHeight = mImage->getHeight();
 }
@@ -3666,6 +4506,7 @@ void CObject::Init()
 		CMN_ASSERT(mImage->isValid());
 		mWidth = mImage->getWidth();
 		mHeight = mImage->getHeight();
+		mSprite = mPongView->GetSpriteAtlas().Find(mImage);
 	}
 }
 
@@ -3701,19 +4542,33 @@ void CObject::Animate(const double diffSec)
 // 	METHOD:	Draw
 //  tbarram 4/30/17
 /*---------------------------------------------------------------------------*/
-void CObject::Draw(Graphics& g)
+void CObject::Draw(Graphics& g, SpriteBatch* batch)
 {
 	// skip the first bullet draw so it doesn't get offset from the front of the ship
 	if (this->Is(eBullet) && mNumAnimates == 0)
 		return;
 	
-	if (this->Is(eShip))
+	const QualityGovernor& governor = mPongView->GetQualityGovernor();
+	if (this->Is(eMiniMap) && governor.Sheds(eQualityNoMinimap))
+		return;
+	
+	// a sprite at its native size goes in the batch - anything else draws now,
+	// so the batch has to go first
+	const bool batched = (batch && mSprite && mWidth == mSprite->GetWidth() && mHeight == mSprite->GetHeight());
+	if (batch && !batched && !this->Is(eGround))
+		batch->Flush(g);
+	
+	if (batched)
+	{
+		batch->Add(*mSprite, roundToInt(mState.mPos.mX), roundToInt(mState.mPos.mY));
+	}
+	else if (this->Is(eShip))
 	{
 		this->DrawShip(g);
 	}
 	else if (this->Is(eGround))
 	{
-		this->DrawGroundObject(g);
+		this->UpdateGroundObject();
 	}
 	else if (this->Is(eTextBubble))
 	{
@@ -3724,12 +4579,15 @@ void CObject::Draw(Graphics& g)
 		// not sure why we can't just use mCollisionRect here in drawImage
 		const Rectangle<float> r(mState.mPos.mX, mState.mPos.mY, mWidth, mHeight);
 		g.setOpacity(1.0f);
-		g.drawImage(*mImage, r, RectanglePlacement::centred);
+		pong::DrawImageIn(*mImage, r, g);
 	}
 	else
 	{
 		g.setColour(mColor);
-		g.fillEllipse(mState.mPos.mX, mState.mPos.mY, mWidth, mHeight);
+		if (governor.Sheds(eQualitySimpleShapes))
+			g.fillRect((float)mState.mPos.mX, (float)mState.mPos.mY, (float)mWidth, (float)mHeight);
+		else
+			g.fillEllipse(mState.mPos.mX, mState.mPos.mY, mWidth, mHeight);
 	}
 
 	if (!this->Is(eShip))
@@ -3826,6 +4684,429 @@ void CObject::VectorCalc(const double diffSec)
 	}
 }
 
+/*---------------------------------------------------------------------------*/
+// 	Benchmarks
+//   - the fixtures for RunGameBenchmarks (see Benchmark.h) live here since
+//     they need CObject & CObjectPool - each one reseeds rand() so that runs
+//     are repeatable
+/*---------------------------------------------------------------------------*/
+namespace
+{
+	const int32_t kBenchmarkSeed = 1;
+	
+	/*---------------------------------------------------------------------------*/
+	// a headless view to own the objects, with no keys down
+	std::shared_ptr<TPongView> NewBenchmarkView()
+	{
+		srand(kBenchmarkSeed);
+		
+		std::shared_ptr<TPongView> view = std::static_pointer_cast<TPongView>(IPongView::Create(true));
+		view->SetFixedStepMS(kRefreshRateMS);
+		view->InstallKeyStateCallback([](int32_t) { return false; });
+		return view;
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// run the view for a while so the terrain & ship vertices are populated
+	void WarmUpView(TPongView& view, int32_t numTicks)
+	{
+		Image frame(Image::ARGB, kGridWidth, kGridHeight, true);
+		Graphics g(frame);
+		for (int32_t k = 0; k < numTicks; k++)
+			view.Draw(g);
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// an empty pool of its own, so a fixture doesn't disturb the view's
+	std::unique_ptr<CObjectPool> NewBenchmarkPool()
+	{
+		std::unique_ptr<CObjectPool> pool(new CObjectPool());
+		pool->Init();
+		return pool;
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// FillCollisionPool
+	//   - icons (a few with mass) followed by bullets, laid out on a grid so
+	//     nothing touches - every pair gets the full check but nothing dies,
+	//     so each iteration does the same work
+	//   - the bullets go last since their CCD rects extend down & to the right
+	void FillCollisionPool(CObjectPool& pool, TPongView* view, int32_t numObjects)
+	{
+		const int32_t kCols = 32;
+		const double kSpacingH = (kGridWidth / (double)kCols);
+		const double kSpacingV = 24;
+		const int32_t numIcons = (numObjects - (numObjects / 4));
+		
+		for (int32_t k = 0; k < numObjects; k++)
+		{
+			const bool isBullet = (k >= numIcons);
+			const CVector p(10 + ((k % kCols) * kSpacingH), 10 + ((k / kCols) * kSpacingV));
+			const int32_t killedBy = isBullet ? (eIcon | eVector) : (eBullet | eShip | eGround);
+			
+			CObject* obj = pool.NewObject(view, isBullet ? eBullet : eIcon, {p, zero, zero, 0, killedBy});
+			if (!obj)
+				break;
+			
+			obj->SetWidthAndHeight(8, 8);
+			if (!isBullet && (k % 16) == 1)
+				obj->SetMass(10);
+		}
+		
+		// sets the collision rects
+		pool.Animate(0);
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// FillDrawPool - a typical mix of sprites & fragments at random positions
+	void FillDrawPool(CObjectPool& pool, TPongView* view, int32_t numObjects)
+	{
+		const EObjectType kTypes[] = {eIcon, eIcon, eBullet, eFragment};
+		for (int32_t k = 0; k < numObjects; k++)
+		{
+			const CVector p(rnd(kGridWidth - 40), rnd(kGridHeight - 40));
+			if (!pool.NewObject(view, kTypes[k % 4], {p, zero, zero, 0, 0}))
+				break;
+		}
+		
+		// bullets skip their first draw
+		pool.Animate(0);
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// BenchmarkPool - allocation churn, all-pairs collision & gravity
+	void BenchmarkPool(BenchmarkReport& report, TPongView* view)
+	{
+		// allocate & release a batch of fragments
+		{
+			const int32_t kBatch = 256;
+			std::unique_ptr<CObjectPool> pool = NewBenchmarkPool();
+			CObject* objects[kBatch];
+			
+			report.Run("pool/churn256", 4000, [&]()
+			{
+				for (int32_t k = 0; k < kBatch; k++)
+					objects[k] = pool->NewObject(view, eFragment, {zero, zero, zero, 0, 0});
+				for (int32_t k = 0; k < kBatch; k++)
+					pool->FreeObject(*objects[k]);
+			});
+		}
+		
+		for (const int32_t numObjects : {64, 256, 1024})
+		{
+			const std::string name = "interactions/" + std::to_string(numObjects);
+			if (!report.ShouldRun(name))
+				continue;
+			
+			srand(kBenchmarkSeed);
+			std::unique_ptr<CObjectPool> pool = NewBenchmarkPool();
+			FillCollisionPool(*pool, view, numObjects);
+			
+			const int64_t iterations = (2000000 / (numObjects * numObjects)) + 10;
+			report.Run(name, iterations, [&]() { pool->HandleObjectPairInteractions(); });
+		}
+		
+		// gravity between one pair
+		{
+			std::unique_ptr<CObjectPool> pool = NewBenchmarkPool();
+			CObject* o1 = pool->NewObject(view, eGravity, {{500, 600}, zero, zero, 0, eBullet});
+			CObject* o2 = pool->NewObject(view, eGravity, {{300, 400}, zero, zero, 0, eBullet});
+			o1->SetMass(15);
+			o2->SetMass(20);
+			
+			report.Run("gravity/applyPair", 500000, [&]() { pool->ApplyGravity(*o1, *o2); });
+		}
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// BenchmarkTerrainAndShip - the view's own terrain & ship (once it's warmed up)
+	void BenchmarkTerrainAndShip(BenchmarkReport& report, TPongView& view)
+	{
+		CObjectPool& pool = view.GetObjectPool();
+		CObject* ship = view.GetShipObject();
+		
+		report.Run("terrain/shipDistance", 200000, [&]() { pool.CalcShipDistanceToGround(*ship); });
+		report.Run("ship/animate", 200000, [&]() { ship->AnimateShip(); });
+		
+		Image frame(Image::ARGB, kGridWidth, kGridHeight, true);
+		Graphics g(frame);
+		report.Run("terrain/draw", 2000, [&]() { view.DrawTerrain(g); });
+		report.Run("ship/draw", 20000, [&]() { ship->DrawShip(g); });
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// BenchmarkExplosions - the fragment creation only, releasing them between batches
+	void BenchmarkExplosions(BenchmarkReport& report, TPongView& view)
+	{
+		for (const bool isShip : {false, true})
+		{
+			const std::string name = (isShip ? "explosion/ship" : "explosion");
+			if (!report.ShouldRun(name))
+				continue;
+			
+			srand(kBenchmarkSeed);
+			const int32_t kBatch = 8;
+			const int64_t iterations = report.Iterations(4000);
+			const CVector pos(kGridWidth / 2, kGridHeight / 2);
+			int64_t ticks = 0;
+			
+			for (int64_t k = 0; k < iterations; k++)
+			{
+				const int64_t start = Time::getHighResolutionTicks();
+				for (int32_t j = 0; j < kBatch; j++)
+					view.Explosion(pos, isShip);
+				ticks += (Time::getHighResolutionTicks() - start);
+				
+				view.GetParticles().Clear();
+			}
+			
+			report.Add(name, iterations * kBatch, TicksToMS(ticks));
+		}
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// BenchmarkDraw
+	//   - software rendering of a pool into an offscreen image
+	//   - 1000 icons at fractional positions - resampled (the old draw path),
+	//     blitted at whole pixels, and batched from the atlas
+	void BenchmarkDraw(BenchmarkReport& report, TPongView& view)
+	{
+		for (const int32_t numObjects : {256, 1000})
+		{
+			const std::string name = "draw/pool" + std::to_string(numObjects);
+			if (!report.ShouldRun(name))
+				continue;
+			
+			srand(kBenchmarkSeed);
+			std::unique_ptr<CObjectPool> pool = NewBenchmarkPool();
+			FillDrawPool(*pool, &view, numObjects);
+			
+			Image frame(Image::ARGB, kGridWidth, kGridHeight, true);
+			Graphics g(frame);
+			report.Run(name, 200, [&]() { pool->Draw(g); });
+		}
+		
+		const int32_t kNumIcons = 1000;
+		srand(kBenchmarkSeed);
+		
+		std::vector<const Image*> icons;
+		std::vector<Rectangle<float>> rects;
+		for (int32_t k = 0; k < kNumIcons; k++)
+		{
+			const Image& img = view.GetImages()[k % view.GetImages().size()];
+			icons.push_back(&img);
+			rects.push_back({(float)(rnd(kGridWidth - 40) + 0.37), (float)(rnd(kGridHeight - 40) + 0.61),
+							 (float)img.getWidth(), (float)img.getHeight()});
+		}
+		
+		Image frame(Image::ARGB, kGridWidth, kGridHeight, true);
+		Graphics g(frame);
+		
+		report.Run("draw/icons1000/resampled", 100, [&]()
+		{
+			for (int32_t k = 0; k < kNumIcons; k++)
+				g.drawImage(*icons[k], rects[k], RectanglePlacement::centred);
+		});
+		
+		report.Run("draw/icons1000/blit", 100, [&]()
+		{
+			for (int32_t k = 0; k < kNumIcons; k++)
+				pong::DrawImageIn(*icons[k], rects[k], g);
+		});
+		
+		SpriteBatch batch;
+		report.Run("draw/icons1000/atlas", 100, [&]()
+		{
+			for (int32_t k = 0; k < kNumIcons; k++)
+			{
+				if (const Sprite* sprite = view.GetSpriteAtlas().Find(icons[k]))
+					batch.Add(*sprite, roundToInt(rects[k].getX()), roundToInt(rects[k].getY()));
+			}
+			batch.Flush(g);
+		});
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// BenchmarkTiles
+	//   - a busy frame (sprites, fragments, terrain & text) drawn directly,
+	//     then recorded & rasterized by the TileRenderer on more and more
+	//     threads
+	//   - the tiles have to match the direct draw exactly, for the full frame
+	//     and for a dirty rect frame on top of it (clipped the way
+	//     ClipToDirtyRegion does it) - diff_px is how many pixels didn't, and
+	//     any at all fails the run
+	void BenchmarkTiles(BenchmarkReport& report, TPongView& view)
+	{
+		std::vector<int32_t> threadCounts;
+		for (int32_t numThreads = 1; numThreads <= std::max(1, SystemStats::getNumCpus()); numThreads *= 2)
+		{
+			if (report.ShouldRun("render/tiles/" + std::to_string(numThreads)))
+				threadCounts.push_back(numThreads);
+		}
+		
+		const bool direct = report.ShouldRun("render/tiles/direct");
+		if (!direct && threadCounts.empty())
+			return;
+		
+		srand(kBenchmarkSeed);
+		std::unique_ptr<CObjectPool> pool = NewBenchmarkPool();
+		FillDrawPool(*pool, &view, 1000);
+		
+		std::unique_ptr<ParticleSystem> particles(new ParticleSystem());
+		for (int32_t k = 0; k < 5000; k++)
+		{
+			const CVector v = CVector::Velocity(rnd(5, 30), rndf() * 2 * M_PI);
+			particles->Add({(float)rnd(kGridWidth), (float)rnd(kGridHeight), (float)v.mX, (float)v.mY, 0, 0, gNowMS + 3600000,
+							rnd(ParticleSystem::kNumColours), (float)rnd(2, 6)});
+		}
+		
+		// the view's terrain was filled in by RunGameBenchmarks
+		const Font font(22.0f);
+		auto drawScene = [&](Graphics& g, Colour background)
+		{
+			g.fillAll(background);
+			pool->Draw(g);
+			particles->Draw(g);
+			view.DrawTerrain(g);
+			
+			g.setFont(font);
+			g.setColour(Colours::white);
+			for (int32_t k = 0; k < 8; k++)
+				g.drawText("Level 12   HP 100   Objects 1000", 20, 20 + (k * 90), 600, 30, Justification::left);
+		};
+		
+		auto drawFrame = [&](Graphics& g) { drawScene(g, Colours::black); };
+		
+		// a scatter of object sized rects, not lined up with the tiles - the
+		// background differs, so anything drawn outside them shows up
+		RectangleList<int> dirty;
+		for (int32_t k = 0; k < 60; k++)
+			dirty.add({rnd(kGridWidth - 60), rnd(kGridHeight - 60), rnd(8, 60), rnd(8, 60)});
+		
+		auto drawDirtyFrame = [&](Graphics& g)
+		{
+			g.reduceClipRegion(dirty);
+			drawScene(g, Colours::darkgrey);
+		};
+		
+		Image expected(Image::RGB, kGridWidth, kGridHeight, true);
+		{
+			Graphics g(expected);
+			drawFrame(g);
+		}
+		
+		Image expectedDirty = expected.createCopy();
+		{
+			Graphics g(expectedDirty);
+			drawDirtyFrame(g);
+		}
+		
+		if (direct)
+		{
+			Image frame(Image::RGB, kGridWidth, kGridHeight, true);
+			Graphics g(frame);
+			report.Run("render/tiles/direct", 100, [&]() { drawFrame(g); });
+		}
+		
+		for (const int32_t numThreads : threadCounts)
+		{
+			const std::string name = "render/tiles/" + std::to_string(numThreads);
+			Image frame(Image::RGB, kGridWidth, kGridHeight, true);
+			TileRenderer renderer(numThreads);
+			renderer.Render(frame, drawFrame);
+			int64_t diff = CountDifferentPixels(expected, frame);
+			
+			renderer.Render(frame, drawDirtyFrame);
+			diff += CountDifferentPixels(expectedDirty, frame);
+			
+			if (diff)
+				report.Fail(name + ": " + std::to_string(diff) + " pixels differ from the direct draw");
+			
+			const int64_t iterations = report.Iterations(100);
+			double rasterMS = 0;
+			const int64_t start = Time::getHighResolutionTicks();
+			for (int64_t k = 0; k < iterations; k++)
+			{
+				renderer.Render(frame, drawFrame);
+				rasterMS += renderer.GetRasterMS();
+			}
+			
+			report.Add(name, iterations, TicksToMS(Time::getHighResolutionTicks() - start),
+					   {{"threads", (double)numThreads}, {"raster_ms", rasterMS / iterations}, {"diff_px", (double)diff}});
+		}
+	}
+	
+	/*---------------------------------------------------------------------------*/
+	// BenchmarkDistanceFrame
+	//   - a whole Distance Game frame, rendered in software & copied to a
+	//     'window' the way MainComponent does it - every pixel, then only the
+	//     dirty rects
+	void BenchmarkDistanceFrame(BenchmarkReport& report)
+	{
+		for (const bool dirty : {false, true})
+		{
+			const std::string name = (dirty ? "render/distanceDirty" : "render/distanceFull");
+			if (!report.ShouldRun(name))
+				continue;
+			
+			std::shared_ptr<TPongView> scene = NewBenchmarkView();
+			scene->SetGameMode(eDistanceGame);
+			scene->SetDirtyRectsEnabled(dirty, Colours::black);
+			
+			Image frame(Image::RGB, kGridWidth, kGridHeight, true);
+			Image window(Image::RGB, kGridWidth, kGridHeight, true);
+			Graphics g(frame);
+			Graphics gw(window);
+			
+			auto renderFrame = [&]()
+			{
+				if (!dirty)
+					g.fillAll(Colours::black);
+				scene->Draw(g);
+				
+				for (const CRect& r : scene->GetDirtyRectangles())
+					gw.drawImage(frame, r.getX(), r.getY(), r.getWidth(), r.getHeight(), r.getX(), r.getY(), r.getWidth(), r.getHeight());
+			};
+			
+			// let the terrain fill in
+			for (int32_t k = 0; k < 200; k++)
+				renderFrame();
+			
+			const int64_t iterations = report.Iterations(1000);
+			double coverage = 0;
+			const int64_t start = Time::getHighResolutionTicks();
+			for (int64_t k = 0; k < iterations; k++)
+			{
+				renderFrame();
+				coverage += scene->GetDirtyCoverage();
+			}
+			
+			report.Add(name, iterations, TicksToMS(Time::getHighResolutionTicks() - start),
+					   {{"screen_pct", 100.0 * coverage / iterations}});
+			scene->InstallKeyStateCallback(nullptr);
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RunGameBenchmarks
+/*---------------------------------------------------------------------------*/
+void pong::RunGameBenchmarks(BenchmarkReport& report)
+{
+	std::shared_ptr<TPongView> view = NewBenchmarkView();
+	BenchmarkPool(report, view.get());
+	
+	// the rest use the view's terrain & ship vertices
+	WarmUpView(*view, 200);
+	BenchmarkTerrainAndShip(report, *view);
+	BenchmarkExplosions(report, *view);
+	BenchmarkDraw(report, *view);
+	BenchmarkTiles(report, *view);
+	BenchmarkDistanceFrame(report);
+	
+	view->InstallKeyStateCallback(nullptr);
+}
+
 /*---------------------------------------------------------------------------*/
 // TODO: move this into a different file
 std::vector<ObjectHistory> ObjectHistory::gPredefinedShipPath = {
@@ -15,11 +15,35 @@
 typedef std::shared_ptr<class IPongView> IPongViewPtr;
 #define ROTARY_RANGE 5000
 
+enum GameMode
+{
+	eStartScreen,
+	eAsteroids,
+	eDistanceGame,
+	eHostageRescue,
+	eGravityShepherd,
+};
+
+// StressConfig - target populations for the stress mode - each target
+// ramps up linearly from zero over mRampMS
+struct StressConfig
+{
+	int32_t	mNumIcons = 0;			// falling & crawling icons
+	int32_t	mNumVectors = 0;		// vector-path enemies
+	int32_t	mNumGravity = 0;		// gravity bodies
+	int32_t	mExplosionsPerSec = 0;	// explosion storm
+	int32_t	mBulletFansPerSec = 0;	// bullet fans from the ship
+	int32_t	mBulletsPerFan = 16;
+	int64_t	mRampMS = 60000;
+	
+	bool IsActive() const { return mNumIcons || mNumVectors || mNumGravity || mExplosionsPerSec || mBulletFansPerSec; }
+};
+
 // IPongView
 class IPongView
 {
 public:
-	static IPongViewPtr Create();
+	static IPongViewPtr Create(bool headless = false);
 	virtual void Draw(Graphics& g) {};
 	virtual int32_t GetRefreshrateMS() { return 100; };
 	virtual int32_t GetGridWidth() { return 0; };
@@ -30,5 +54,22 @@ public:
 	virtual void InstallHighScoreCallback(std::function<void(std::string)> f) {};
 	virtual Colour ColorForScore(int32_t score) { return Colours::red; }
 	virtual void SetHighScore(std::string score) {};
+	
+	// for driving the game without a window (see Simulation.cpp)
+	virtual void SetFixedStepMS(int32_t stepMS) {};
+	virtual void InstallKeyStateCallback(std::function<bool(int32_t)> f) {};
+	virtual void SetGameMode(GameMode mode) {};
+	virtual int32_t GetNumActiveObjects() { return 0; }; // explosion fragments included
+	virtual void SetStressConfig(const StressConfig& config) {};
+	virtual void SetQualityGovernorEnabled(bool enabled) {};
+	
+	// the game is laid out on a fixed grid - Draw() scales all of it (sprites,
+	// lines & text) by this, for a window that's bigger or smaller than the grid
+	virtual void SetRenderScale(float scale) {};
+	
+	// dirty rects - the caller keeps the frame between Draw() calls, and Draw()
+	// only clears (to background) & redraws the parts that changed
+	virtual void SetDirtyRectsEnabled(bool enabled, Colour background) {};
+	virtual RectangleList<int> GetDirtyRectangles() { return RectangleList<int>(Rectangle<int>(0, 0, this->GetGridWidth(), this->GetGridHeight())); };
 	virtual ~IPongView() {}
 };
@@ -0,0 +1,265 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	SpriteAtlas.cpp
+*****************************************************************************/
+
+#include "SpriteAtlas.h"
+#include "Trace.h"
+#include <algorithm>
+#include <memory>
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+void SpriteAtlas::Add(const Image* img)
+{
+	if (img && img->isValid() && !mSprites.count(img) &&
+		std::find(mPending.begin(), mPending.end(), img) == mPending.end())
+		mPending.push_back(img);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Build
+//   - shelf packing, tallest first, so each shelf wastes little height
+/*---------------------------------------------------------------------------*/
+void SpriteAtlas::Build()
+{
+	std::stable_sort(mPending.begin(), mPending.end(), [](const Image* a, const Image* b)
+	{
+		return a->getHeight() > b->getHeight();
+	});
+	
+	std::unique_ptr<Graphics> page;
+	for (const Image* img : mPending)
+	{
+		const int32_t w = img->getWidth() + kPadding;
+		const int32_t h = img->getHeight() + kPadding;
+		if (w > kPageSize || h > kPageSize)
+			continue;
+		
+		// next shelf, then next page
+		if (mPages.empty() || mShelfX + w > kPageSize)
+		{
+			mShelfX = 0;
+			mShelfY += mShelfHeight;
+			mShelfHeight = 0;
+		}
+		
+		if (mPages.empty() || mShelfY + h > kPageSize)
+		{
+			mPages.push_back(Image(Image::ARGB, kPageSize, kPageSize, true));
+			page.reset();
+			mShelfX = mShelfY = mShelfHeight = 0;
+		}
+		
+		if (!page)
+			page.reset(new Graphics(mPages.back()));
+		
+		// premultiplied from here on, whatever the file was
+		const Rectangle<int> source(mShelfX, mShelfY, img->getWidth(), img->getHeight());
+		page->drawImageAt(*img, source.getX(), source.getY());
+		
+		mSprites[img] = {(int32_t)mPages.size() - 1, source, mPages.back().getClippedImage(source)};
+		
+		mShelfX += w;
+		mShelfHeight = std::max(mShelfHeight, h);
+	}
+	
+	mPending.clear();
+}
+
+/*---------------------------------------------------------------------------*/
+const Sprite* SpriteAtlas::Find(const Image* img) const
+{
+	const auto it = mSprites.find(img);
+	return (it != mSprites.end() ? &it->second : nullptr);
+}
+
+/*---------------------------------------------------------------------------*/
+std::vector<const Sprite*> SpriteAtlas::GetSprites() const
+{
+	std::vector<const Sprite*> sprites;
+	for (const auto& entry : mSprites)
+		sprites.push_back(&entry.second);
+	
+	return sprites;
+}
+
+/*---------------------------------------------------------------------------*/
+// ScaledSprites::Builder - builds whichever scale is wanted, then sleeps
+/*---------------------------------------------------------------------------*/
+class ScaledSprites::Builder : public Thread
+{
+public:
+	Builder(ScaledSprites& owner) : Thread("ScaledSprites"), mOwner(owner) {}
+	
+	virtual void run() override
+	{
+		gTraceRecorder.SetThreadName("spriteScaler");
+		
+		while (!this->threadShouldExit())
+		{
+			std::vector<const Sprite*> sprites;
+			float scale = 1.0f;
+			bool built = true;
+			{
+				const ScopedLock lock(mOwner.mLock);
+				sprites = mOwner.mSprites;
+				scale = mOwner.mWantedScale;
+				built = (scale == 1.0f || (mOwner.mSet && mOwner.mSet->mScale == scale));
+			}
+			
+			if (built)
+			{
+				this->wait(-1);
+				continue;
+			}
+			
+			// (nullptr if the scale changed again while it was building)
+			std::shared_ptr<const Set> set = mOwner.Build(sprites, scale);
+			
+			const ScopedLock lock(mOwner.mLock);
+			if (set && mOwner.mWantedScale == scale)
+				mOwner.mSet = set;
+		}
+	}
+
+private:
+	ScaledSprites&	mOwner;
+};
+
+/*---------------------------------------------------------------------------*/
+ScaledSprites::ScaledSprites()
+{
+}
+
+/*---------------------------------------------------------------------------*/
+ScaledSprites::~ScaledSprites()
+{
+	if (mBuilder)
+	{
+		mBuilder->signalThreadShouldExit();
+		mBuilder->notify();
+		mBuilder->stopThread(2000);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	SetScale
+//   - the builder thread is only started the first time the scale isn't 1
+/*---------------------------------------------------------------------------*/
+void ScaledSprites::SetScale(const SpriteAtlas& atlas, float scale)
+{
+	{
+		const ScopedLock lock(mLock);
+		if (scale == mWantedScale)
+			return;
+		
+		mWantedScale = scale;
+		mSprites = atlas.GetSprites();
+	}
+	
+	if (!mBuilder)
+	{
+		mBuilder.reset(new Builder(*this));
+		mBuilder->startThread();
+	}
+	
+	mBuilder->notify();
+}
+
+/*---------------------------------------------------------------------------*/
+std::shared_ptr<const ScaledSprites::Set> ScaledSprites::GetSet() const
+{
+	const ScopedLock lock(mLock);
+	return mSet;
+}
+
+/*---------------------------------------------------------------------------*/
+bool ScaledSprites::IsWanted(float scale) const
+{
+	const ScopedLock lock(mLock);
+	return (scale == mWantedScale);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Build
+//   - on the builder thread - gives up as soon as scale isn't wanted any more
+/*---------------------------------------------------------------------------*/
+std::shared_ptr<const ScaledSprites::Set> ScaledSprites::Build(const std::vector<const Sprite*>& sprites, float scale) const
+{
+	StTraceScope trace("scaleSprites");
+	std::shared_ptr<Set> set(new Set());
+	set->mScale = scale;
+	
+	for (const Sprite* sprite : sprites)
+	{
+		if (Thread::currentThreadShouldExit() || !this->IsWanted(scale))
+			return nullptr;
+		
+		const int32_t w = std::max(1, roundToInt(sprite->GetWidth() * scale));
+		const int32_t h = std::max(1, roundToInt(sprite->GetHeight() * scale));
+		set->mImages[sprite] = sprite->mImage.rescaled(w, h, Graphics::highResamplingQuality);
+	}
+	
+	printf("sprites: %d pre-scaled to %.3fx\n", (int32_t)sprites.size(), scale);
+	return set;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Flush
+//   - integer translations only, so JUCE copies rows instead of resampling
+/*---------------------------------------------------------------------------*/
+void SpriteBatch::Flush(Graphics& g)
+{
+	if (mDraws.empty())
+		return;
+	
+	g.setOpacity(1.0f);
+	if (mScale != 1.0f)
+	{
+		this->FlushScaled(g);
+	}
+	else
+	{
+		for (const SpriteDraw& d : mDraws)
+		{
+			const Rectangle<int> dest(d.mX, d.mY, d.mSprite->GetWidth(), d.mSprite->GetHeight());
+			if (g.clipRegionIntersects(dest))
+				g.drawImageAt(d.mSprite->mImage, d.mX, d.mY);
+		}
+	}
+	
+	mDraws.clear();
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	FlushScaled
+//   - g is scaled, so the pre-scaled sprites are drawn through the inverse,
+//     at whole device pixels (JUCE blits anything within a hair of a plain
+//     translation) - sprites that aren't pre-scaled yet get resampled
+/*---------------------------------------------------------------------------*/
+void SpriteBatch::FlushScaled(Graphics& g)
+{
+	const bool ready = (mScaled && mScaled->mScale == mScale);
+	
+	Graphics::ScopedSaveState state(g);
+	g.addTransform(AffineTransform::scale(1.0f / mScale));
+	
+	for (const SpriteDraw& d : mDraws)
+	{
+		const Rectangle<float> r((float)d.mX, (float)d.mY, (float)d.mSprite->GetWidth(), (float)d.mSprite->GetHeight());
+		if (!g.clipRegionIntersects((r * mScale).getSmallestIntegerContainer()))
+			continue;
+		
+		if (const Image* img = (ready ? mScaled->Find(d.mSprite) : nullptr))
+			g.drawImageAt(*img, roundToInt(r.getX() * mScale), roundToInt(r.getY() * mScale));
+		else
+			g.drawImageTransformed(d.mSprite->mImage, AffineTransform::translation(r.getX(), r.getY()).scaled(mScale));
+	}
+}
+
+} // pong namespace
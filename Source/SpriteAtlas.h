@@ -0,0 +1,148 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	SpriteAtlas.h
+	
+	The sprite images (icons, gravity bodies, hostages, bullets, the chaser)
+	packed at load time into a few premultiplied ARGB pages. Each sprite is
+	a sub-image sharing its page's pixels, so hundreds of icons on screen
+	read from one small block of memory instead of dozens of separate ones.
+	
+	CObjectPool::Draw collects the sprites drawn at their native size into
+	a SpriteBatch, which blits them at whole pixels (no resampling) in one
+	go, skipping any outside the clip region.
+	
+	When the game is drawn scaled (to fit a bigger window), ScaledSprites
+	keeps every sprite resampled once for that scale, so the batch can
+	still blit them at whole device pixels. A new scale is built on a
+	background thread - until it's ready, the batch resamples as it draws.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace pong
+{
+
+// Sprite - an image's place in the atlas
+struct Sprite
+{
+	int32_t			mPage;
+	Rectangle<int>	mSource;	// within the page
+	Image			mImage;		// mSource of the page (shares its pixels)
+	
+	int32_t GetWidth() const { return mSource.getWidth(); }
+	int32_t GetHeight() const { return mSource.getHeight(); }
+};
+
+// SpriteAtlas
+class SpriteAtlas
+{
+public:
+	static const int32_t kPageSize = 1024;
+	static const int32_t kPadding = 1; // transparent gutter between sprites
+	
+	// queues an image for packing - the image is the lookup key, so it needs
+	// to stay where it is for as long as the atlas is used
+	void	Add(const Image* img);
+	
+	// packs everything added since the last Build (images that don't fit on
+	// a page are left out, and keep drawing on their own)
+	void	Build();
+	
+	// nullptr if img isn't in the atlas
+	const Sprite* Find(const Image* img) const;
+	std::vector<const Sprite*> GetSprites() const;
+	
+	int32_t	GetNumPages() const { return (int32_t)mPages.size(); }
+	int32_t	GetNumSprites() const { return (int32_t)mSprites.size(); }
+
+private:
+	std::vector<const Image*> mPending;
+	std::vector<Image> mPages;
+	std::unordered_map<const Image*, Sprite> mSprites;
+	
+	// where the next sprite goes on the last page
+	int32_t	mShelfX = 0;
+	int32_t	mShelfY = 0;
+	int32_t	mShelfHeight = 0;
+};
+
+// ScaledSprites - the atlas's sprites pre-scaled for one render scale
+class ScaledSprites
+{
+public:
+	struct Set
+	{
+		float	mScale;
+		std::unordered_map<const Sprite*, Image> mImages;
+		
+		// nullptr if sprite isn't in the set
+		const Image* Find(const Sprite* sprite) const
+		{
+			const auto it = mImages.find(sprite);
+			return (it != mImages.end() ? &it->second : nullptr);
+		}
+	};
+	
+	ScaledSprites();
+	~ScaledSprites();
+	
+	// starts building the atlas's sprites at scale in the background, unless
+	// that's the scale already built (or being built)
+	void	SetScale(const SpriteAtlas& atlas, float scale);
+	
+	// the last set built (nullptr before the first) - draws hold on to it for the frame
+	std::shared_ptr<const Set> GetSet() const;
+
+private:
+	class Builder;
+	
+	std::shared_ptr<const Set> Build(const std::vector<const Sprite*>& sprites, float scale) const;
+	bool	IsWanted(float scale) const;
+	
+	CriticalSection		mLock;
+	std::vector<const Sprite*> mSprites;	// mLock - what to build ...
+	float				mWantedScale = 1.0f;	// mLock - ... and at what scale
+	std::shared_ptr<const Set> mSet;		// mLock
+	
+	std::unique_ptr<Builder> mBuilder;
+};
+
+// SpriteBatch - native size sprite draws, blitted together at whole pixels
+class SpriteBatch
+{
+public:
+	void	Add(const Sprite& sprite, int32_t x, int32_t y) { mDraws.push_back({&sprite, x, y}); }
+	bool	IsEmpty() const { return mDraws.empty(); }
+	
+	// the game's render scale, and the sprites pre-scaled for it (if they're ready)
+	void	SetScale(float scale, std::shared_ptr<const ScaledSprites::Set> scaled)
+	{
+		mScale = scale;
+		mScaled = std::move(scaled);
+	}
+	
+	// draws everything added since the last Flush, in order
+	void	Flush(Graphics& g);
+
+private:
+	struct SpriteDraw
+	{
+		const Sprite*	mSprite;
+		int32_t			mX;
+		int32_t			mY;
+	};
+	
+	void	FlushScaled(Graphics& g);
+	
+	std::vector<SpriteDraw> mDraws;
+	float				mScale = 1.0f;
+	std::shared_ptr<const ScaledSprites::Set> mScaled;
+};
+
+} // pong namespace
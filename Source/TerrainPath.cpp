@@ -0,0 +1,85 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	TerrainPath.cpp
+*****************************************************************************/
+
+#include "TerrainPath.h"
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+void TerrainPath::Append(const Point<double>& left, const Point<double>& right)
+{
+	const Point<double> offset(mOffset, 0);
+	mSegments.push_back({left - offset, right - offset});
+	this->AddToPath(mSegments.back());
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	AddToPath
+//   - the segment before s is already in the path (if there is one)
+/*---------------------------------------------------------------------------*/
+void TerrainPath::AddToPath(const Segment& s)
+{
+	// a segment starts at the last one's right endpoint, give or take rounding
+	const bool joined = (!mPath.isEmpty() && mPath.getCurrentPosition().toDouble().getDistanceFrom(s.mLeft) < 0.5);
+	if (!joined)
+		mPath.startNewSubPath(s.mLeft.toFloat());
+	
+	mPath.lineTo(s.mRight.toFloat());
+}
+
+/*---------------------------------------------------------------------------*/
+void TerrainPath::DropFirst()
+{
+	if (mSegments.empty())
+		return;
+	
+	mSegments.pop_front();
+	if (mSegments.empty())
+		this->Clear();
+	else if (++mNumStale > kMaxStaleSegments)
+		this->Rebuild();
+}
+
+/*---------------------------------------------------------------------------*/
+void TerrainPath::Clear()
+{
+	mSegments.clear();
+	mPath.clear();
+	mOffset = 0;
+	mNumStale = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Rebuild
+//   - just the live segments, moved so the offset is back to 0 (so the
+//     float path coordinates don't grow for as long as the game runs)
+/*---------------------------------------------------------------------------*/
+void TerrainPath::Rebuild()
+{
+	mPath.clear();
+	for (Segment& s : mSegments)
+	{
+		s.mLeft.x += mOffset;
+		s.mRight.x += mOffset;
+		this->AddToPath(s);
+	}
+	
+	mOffset = 0;
+	mNumStale = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+void TerrainPath::Draw(Graphics& g, float thickness) const
+{
+	if (mPath.isEmpty())
+		return;
+	
+	g.strokePath(mPath, PathStrokeType(thickness), AffineTransform::translation((float)mOffset, 0));
+}
+
+} // pong namespace
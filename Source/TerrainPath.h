@@ -0,0 +1,68 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	TerrainPath.h
+	
+	One of the ground lines (the bottom, or the top in the corridor games),
+	drawn as a single polyline. The ground segments are still CObjects -
+	they do the collisions & spawn the next segment - but instead of each
+	one drawing its own line, their endpoints go into one Path that's
+	stroked once per frame.
+	
+	All of a line's segments scroll left at the same speed, so the path
+	never changes as it scrolls - it's kept in its own coordinates and
+	drawn through a translation that Scroll() moves along. New segments are
+	appended to the end, and the ones that scrolled off the left stay in
+	the path (clipped) until enough of them pile up to rebuild it.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <deque>
+
+namespace pong
+{
+
+// TerrainPath
+class TerrainPath
+{
+public:
+	static const int32_t kMaxStaleSegments = 32; // dropped but still in the path
+	
+	// a new segment, in screen coordinates - one that doesn't start where the
+	// last one ended starts a new sub-path
+	void	Append(const Point<double>& left, const Point<double>& right);
+	
+	// the oldest segment died
+	void	DropFirst();
+	void	Clear();
+	
+	// every segment moved dx (screen coordinates)
+	void	Scroll(double dx)
+	{
+		if (!mSegments.empty())
+			mOffset += dx;
+	}
+	
+	void	Draw(Graphics& g, float thickness) const;
+	
+	int32_t	GetNumSegments() const { return (int32_t)mSegments.size(); }
+
+private:
+	struct Segment
+	{
+		Point<double>	mLeft;	// path coordinates
+		Point<double>	mRight;
+	};
+	
+	void	AddToPath(const Segment& s);
+	void	Rebuild();
+	
+	std::deque<Segment> mSegments; // the live ones, oldest first
+	Path		mPath;
+	double		mOffset = 0;	// screen x = path x + mOffset
+	int32_t		mNumStale = 0;
+};
+
+} // pong namespace
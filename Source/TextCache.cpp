@@ -0,0 +1,88 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	TextCache.cpp
+*****************************************************************************/
+
+#include "TextCache.h"
+#include "CachedLayer.h"
+
+namespace pong
+{
+
+/*---------------------------------------------------------------------------*/
+void TextCache::DrawText(Graphics& g, const std::string& text, const Font& font, const Rectangle<int>& box,
+						 Justification justification, bool useEllipses)
+{
+	this->Draw(g, text, font, box, justification, useEllipses ? eLineEllipses : eLine);
+}
+
+/*---------------------------------------------------------------------------*/
+void TextCache::DrawFittedText(Graphics& g, const std::string& text, const Font& font, const Rectangle<int>& box,
+							   Justification justification, int32_t maxLines)
+{
+	this->Draw(g, text, font, box, justification, eFitted + (maxLines << 2));
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Draw
+//   - find (or lay out) the glyphs at the origin, and draw them at the box
+/*---------------------------------------------------------------------------*/
+void TextCache::Draw(Graphics& g, const std::string& text, const Font& font, const Rectangle<int>& box,
+					 Justification justification, int32_t kind)
+{
+	if (text.empty() || box.isEmpty())
+		return;
+	
+	const uint64_t key = LayerKey().Add(text).Add(font.getTypefaceName().hashCode64()).Add((int64_t)(font.getHeight() * 64))
+								   .Add(font.getStyleFlags()).Add(box.getWidth()).Add(box.getHeight())
+								   .Add(justification.getFlags()).Add(kind).Get();
+	
+	Entry& e = mEntries[key];
+	if (e.mText != text || e.mFont != font || e.mWidth != box.getWidth() || e.mHeight != box.getHeight() ||
+		e.mJustification != justification.getFlags() || e.mKind != kind)
+	{
+		// new (or a hash collision) - the same layout Graphics would do
+		const float w = (float)box.getWidth(), h = (float)box.getHeight();
+		e.mGlyphs.clear();
+		if ((kind & 3) == eFitted)
+		{
+			e.mGlyphs.addFittedText(font, text, 0, 0, w, h, justification, kind >> 2);
+		}
+		else
+		{
+			e.mGlyphs.addCurtailedLineOfText(font, text, 0, 0, w, kind == eLineEllipses);
+			e.mGlyphs.justifyGlyphs(0, e.mGlyphs.getNumGlyphs(), 0, 0, w, h, justification);
+		}
+		
+		e.mText = text;
+		e.mFont = font;
+		e.mWidth = box.getWidth();
+		e.mHeight = box.getHeight();
+		e.mJustification = justification.getFlags();
+		e.mKind = kind;
+		mNumLayouts++;
+	}
+	
+	e.mLastUsedFrame = mFrame;
+	e.mGlyphs.draw(g, AffineTransform::translation((float)box.getX(), (float)box.getY()));
+}
+
+/*---------------------------------------------------------------------------*/
+void TextCache::EndFrame()
+{
+	mFrame++;
+	if ((mFrame % kMaxAgeFrames) != 0)
+		return;
+	
+	for (auto it = mEntries.begin(); it != mEntries.end(); )
+	{
+		if (mFrame - it->second.mLastUsedFrame > kMaxAgeFrames)
+			it = mEntries.erase(it);
+		else
+			++it;
+	}
+}
+
+} // pong namespace
@@ -0,0 +1,71 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	TextCache.h
+	
+	Laid out text, keyed on (string, font, box size, justification). Most
+	HUD text is the same from one frame to the next, so drawing it is just
+	drawing the cached GlyphArrangement - the layout (glyph lookup, widths,
+	fitting & justification) only happens when the text changes.
+	
+	The glyphs are laid out at the origin and translated to the box when
+	drawn, so text that moves without changing (the text bubbles) hits the
+	cache too. Entries that haven't been drawn for a while are dropped.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <string>
+#include <unordered_map>
+
+namespace pong
+{
+
+// TextCache
+class TextCache
+{
+public:
+	static const int64_t kMaxAgeFrames = 60; // unused this long and it's dropped
+	
+	// like Graphics::drawText & drawFittedText, in g's current colour
+	void	DrawText(Graphics& g, const std::string& text, const Font& font, const Rectangle<int>& box,
+					 Justification justification, bool useEllipses = true);
+	void	DrawFittedText(Graphics& g, const std::string& text, const Font& font, const Rectangle<int>& box,
+						   Justification justification, int32_t maxLines);
+	
+	// once per frame, for the aging
+	void	EndFrame();
+	
+	int32_t	GetNumEntries() const { return (int32_t)mEntries.size(); }
+	int64_t	GetNumLayouts() const { return mNumLayouts; }
+
+private:
+	enum Kind
+	{
+		eLine,			// drawText
+		eLineEllipses,	// drawText, with "..." if it doesn't fit
+		eFitted			// drawFittedText
+	};
+	
+	struct Entry
+	{
+		std::string		mText;
+		Font			mFont;
+		int32_t			mWidth = 0;
+		int32_t			mHeight = 0;
+		int32_t			mJustification = 0;
+		int32_t			mKind = 0;	// Kind, plus maxLines for eFitted
+		GlyphArrangement mGlyphs;
+		int64_t			mLastUsedFrame = 0;
+	};
+	
+	void	Draw(Graphics& g, const std::string& text, const Font& font, const Rectangle<int>& box,
+				 Justification justification, int32_t kind);
+	
+	std::unordered_map<uint64_t, Entry> mEntries;
+	int64_t	mFrame = 0;
+	int64_t	mNumLayouts = 0;
+};
+
+} // pong namespace
@@ -0,0 +1,496 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	TileRenderer.cpp
+*****************************************************************************/
+
+#include "TileRenderer.h"
+#include "Trace.h"
+#include <algorithm>
+#include <math.h>
+
+/*---------------------------------------------------------------------------*/
+void DrawList::Reset(const Rectangle<int>& bounds)
+{
+	mOps.clear();
+	mNumDraws = 0;
+	mFrameBounds = bounds;
+	mState = {AffineTransform(), bounds, Font()};
+	mSavedStates.clear();
+	
+	mPaths.clear();
+	mImages.clear();
+	mFills.clear();
+	mFonts.clear();
+	mClipLists.clear();
+	mRectLists.clear();
+}
+
+/*---------------------------------------------------------------------------*/
+DrawList::Op& DrawList::Add(OpType type, const Rectangle<int>& bounds)
+{
+	if (type >= eFirstDraw)
+		mNumDraws++;
+	
+	mOps.push_back({type, bounds, {}, {}, {}, 0, 1.0f});
+	return mOps.back();
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	DeviceBounds
+//   - a pixel bigger all round, for antialiasing & rounding
+/*---------------------------------------------------------------------------*/
+Rectangle<int> DrawList::DeviceBounds(const Rectangle<float>& r, const AffineTransform& t) const
+{
+	return r.transformedBy(t.followedBy(mState.mTransform)).getSmallestIntegerContainer().expanded(1).getIntersection(mState.mClip);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::Replay(int32_t k, LowLevelGraphicsContext& c) const
+{
+	const Op& op = mOps[k];
+	switch (op.mType)
+	{
+		case eSetOrigin:				c.setOrigin(op.mRect.getPosition().toInt()); break;
+		case eAddTransform:				c.addTransform(op.mTransform); break;
+		case eClipToRectangle:			c.clipToRectangle(op.mRect.toNearestInt()); break;
+		case eClipToRectangleList:		c.clipToRectangleList(mClipLists[op.mValue]); break;
+		case eExcludeClipRectangle:		c.excludeClipRectangle(op.mRect.toNearestInt()); break;
+		case eClipToPath:				c.clipToPath(mPaths[op.mValue], op.mTransform); break;
+		case eClipToImageAlpha:			c.clipToImageAlpha(mImages[op.mValue], op.mTransform); break;
+		case eSaveState:				c.saveState(); break;
+		case eRestoreState:				c.restoreState(); break;
+		case eSetFill:					c.setFill(mFills[op.mValue]); break;
+		case eSetOpacity:				c.setOpacity(op.mOpacity); break;
+		case eSetInterpolationQuality:	c.setInterpolationQuality((Graphics::ResamplingQuality)op.mValue); break;
+		case eSetFont:					c.setFont(mFonts[op.mValue]); break;
+		
+		case eBeginTransparencyLayer:	c.beginTransparencyLayer(op.mOpacity); break;
+		case eEndTransparencyLayer:		c.endTransparencyLayer(); break;
+		case eFillRectInt:				c.fillRect(op.mRect.toNearestInt(), (op.mValue != 0)); break;
+		case eFillRect:					c.fillRect(op.mRect); break;
+		case eFillRectList:				c.fillRectList(mRectLists[op.mValue]); break;
+		case eFillPath:					c.fillPath(mPaths[op.mValue], op.mTransform); break;
+		case eDrawImage:				c.drawImage(mImages[op.mValue], op.mTransform); break;
+		case eDrawLine:					c.drawLine(op.mLine); break;
+		case eDrawGlyph:				c.drawGlyph(op.mValue, op.mTransform); break;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::setOrigin(Point<int> o)
+{
+	this->Add(eSetOrigin).mRect.setPosition(o.toFloat());
+	mState.mTransform = AffineTransform::translation((float)o.x, (float)o.y).followedBy(mState.mTransform);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::addTransform(const AffineTransform& t)
+{
+	this->Add(eAddTransform).mTransform = t;
+	mState.mTransform = t.followedBy(mState.mTransform);
+}
+
+/*---------------------------------------------------------------------------*/
+float DrawList::getPhysicalPixelScaleFactor()
+{
+	return ::sqrtf(::fabsf(mState.mTransform.getDeterminant()));
+}
+
+/*---------------------------------------------------------------------------*/
+bool DrawList::clipToRectangle(const Rectangle<int>& r)
+{
+	this->Add(eClipToRectangle).mRect = r.toFloat();
+	mState.mClip = this->DeviceBounds(r.toFloat());
+	return !this->isClipEmpty();
+}
+
+/*---------------------------------------------------------------------------*/
+bool DrawList::clipToRectangleList(const RectangleList<int>& r)
+{
+	this->Add(eClipToRectangleList).mValue = (int32_t)mClipLists.size();
+	mClipLists.push_back(r);
+	mState.mClip = this->DeviceBounds(r.getBounds().toFloat());
+	return !this->isClipEmpty();
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	excludeClipRectangle
+//   - the bounding box stays as it was (which is still conservative)
+/*---------------------------------------------------------------------------*/
+void DrawList::excludeClipRectangle(const Rectangle<int>& r)
+{
+	this->Add(eExcludeClipRectangle).mRect = r.toFloat();
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::clipToPath(const Path& p, const AffineTransform& t)
+{
+	Op& op = this->Add(eClipToPath);
+	op.mValue = (int32_t)mPaths.size();
+	op.mTransform = t;
+	mPaths.push_back(p);
+	mState.mClip = this->DeviceBounds(p.getBounds(), t);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::clipToImageAlpha(const Image& img, const AffineTransform& t)
+{
+	Op& op = this->Add(eClipToImageAlpha);
+	op.mValue = (int32_t)mImages.size();
+	op.mTransform = t;
+	mImages.push_back(img);
+	mState.mClip = this->DeviceBounds(img.getBounds().toFloat(), t);
+}
+
+/*---------------------------------------------------------------------------*/
+bool DrawList::clipRegionIntersects(const Rectangle<int>& r)
+{
+	return !this->DeviceBounds(r.toFloat()).isEmpty();
+}
+
+/*---------------------------------------------------------------------------*/
+Rectangle<int> DrawList::getClipBounds() const
+{
+	return mState.mClip.toFloat().transformedBy(mState.mTransform.inverted()).getSmallestIntegerContainer();
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::saveState()
+{
+	this->Add(eSaveState);
+	mSavedStates.push_back(mState);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::restoreState()
+{
+	if (mSavedStates.empty())
+		return;
+	
+	this->Add(eRestoreState);
+	mState = mSavedStates.back();
+	mSavedStates.pop_back();
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	beginTransparencyLayer
+//   - the layers go to every tile, so each one's layer matches its end
+/*---------------------------------------------------------------------------*/
+void DrawList::beginTransparencyLayer(float opacity)
+{
+	this->Add(eBeginTransparencyLayer, mFrameBounds).mOpacity = opacity;
+	mSavedStates.push_back(mState);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::endTransparencyLayer()
+{
+	this->Add(eEndTransparencyLayer, mFrameBounds);
+	if (!mSavedStates.empty())
+	{
+		mState = mSavedStates.back();
+		mSavedStates.pop_back();
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::setFill(const FillType& fill)
+{
+	this->Add(eSetFill).mValue = (int32_t)mFills.size();
+	mFills.push_back(fill);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::setOpacity(float opacity)
+{
+	this->Add(eSetOpacity).mOpacity = opacity;
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::setInterpolationQuality(Graphics::ResamplingQuality quality)
+{
+	this->Add(eSetInterpolationQuality).mValue = (int32_t)quality;
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::fillRect(const Rectangle<int>& r, bool replaceExistingContents)
+{
+	const Rectangle<int> bounds = this->DeviceBounds(r.toFloat());
+	if (bounds.isEmpty())
+		return;
+	
+	Op& op = this->Add(eFillRectInt, bounds);
+	op.mRect = r.toFloat();
+	op.mValue = (replaceExistingContents ? 1 : 0);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::fillRect(const Rectangle<float>& r)
+{
+	const Rectangle<int> bounds = this->DeviceBounds(r);
+	if (!bounds.isEmpty())
+		this->Add(eFillRect, bounds).mRect = r;
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::fillRectList(const RectangleList<float>& r)
+{
+	const Rectangle<int> bounds = this->DeviceBounds(r.getBounds());
+	if (bounds.isEmpty())
+		return;
+	
+	this->Add(eFillRectList, bounds).mValue = (int32_t)mRectLists.size();
+	mRectLists.push_back(r);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::fillPath(const Path& p, const AffineTransform& t)
+{
+	const Rectangle<int> bounds = this->DeviceBounds(p.getBounds(), t);
+	if (bounds.isEmpty())
+		return;
+	
+	Op& op = this->Add(eFillPath, bounds);
+	op.mValue = (int32_t)mPaths.size();
+	op.mTransform = t;
+	mPaths.push_back(p);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::drawImage(const Image& img, const AffineTransform& t)
+{
+	const Rectangle<int> bounds = this->DeviceBounds(img.getBounds().toFloat(), t);
+	if (bounds.isEmpty())
+		return;
+	
+	// Image is reference counted, so this doesn't copy the pixels
+	Op& op = this->Add(eDrawImage, bounds);
+	op.mValue = (int32_t)mImages.size();
+	op.mTransform = t;
+	mImages.push_back(img);
+}
+
+/*---------------------------------------------------------------------------*/
+void DrawList::drawLine(const Line<float>& line)
+{
+	const Rectangle<float> r = Rectangle<float>(line.getStart(), line.getEnd());
+	const Rectangle<int> bounds = this->DeviceBounds(r);
+	if (!bounds.isEmpty())
+		this->Add(eDrawLine, bounds).mLine = line;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	setFont
+//   - the text sets the font for every glyph, so only the changes are kept
+/*---------------------------------------------------------------------------*/
+void DrawList::setFont(const Font& font)
+{
+	if (font == mState.mFont)
+		return;
+	
+	this->Add(eSetFont).mValue = (int32_t)mFonts.size();
+	mFonts.push_back(font);
+	mState.mFont = font;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	drawGlyph
+//   - t puts the glyph's baseline origin in place; nothing in a font
+//     reaches further than this from it
+/*---------------------------------------------------------------------------*/
+void DrawList::drawGlyph(int glyphNumber, const AffineTransform& t)
+{
+	const float h = mState.mFont.getHeight();
+	const float w = h * std::max(1.0f, mState.mFont.getHorizontalScale());
+	const Rectangle<int> bounds = this->DeviceBounds({-w, -2 * h, 4 * w, 4 * h}, t);
+	if (bounds.isEmpty())
+		return;
+	
+	Op& op = this->Add(eDrawGlyph, bounds);
+	op.mValue = glyphNumber;
+	op.mTransform = t;
+}
+
+/*---------------------------------------------------------------------------*/
+// TileRenderer::Worker - rasterizes tiles whenever it's woken up
+/*---------------------------------------------------------------------------*/
+class TileRenderer::Worker : public Thread
+{
+public:
+	Worker(TileRenderer& renderer) : Thread("TileRenderer"), mRenderer(renderer) {}
+	
+	virtual void run() override
+	{
+		gTraceRecorder.SetThreadName("tileWorker");
+		
+		while (true)
+		{
+			this->wait(-1);
+			if (this->threadShouldExit())
+				break;
+			
+			mRenderer.RasterizeTiles();
+			if (--mRenderer.mNumBusyWorkers == 0)
+				mRenderer.mWorkersDone.signal();
+		}
+	}
+
+private:
+	TileRenderer&	mRenderer;
+};
+
+/*---------------------------------------------------------------------------*/
+TileRenderer::TileRenderer(int32_t numThreads) :
+	mNextTile(0),
+	mNumBusyWorkers(0)
+{
+	for (int32_t k = 1; k < numThreads; k++)
+	{
+		mWorkers.emplace_back(new Worker(*this));
+		mWorkers.back()->startThread();
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+TileRenderer::~TileRenderer()
+{
+	for (auto& worker : mWorkers)
+	{
+		worker->signalThreadShouldExit();
+		worker->notify();
+		worker->stopThread(1000);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+void TileRenderer::Render(Image& image, const std::function<void(Graphics&)>& draw)
+{
+	StTraceScope trace("tileRender");
+	const int64 start = Time::getHighResolutionTicks();
+	
+	mDrawList.Reset(image.getBounds());
+	{
+		Graphics g(mDrawList);
+		draw(g);
+	}
+	this->Bin(image.getBounds());
+	const int64 recorded = Time::getHighResolutionTicks();
+	
+	mImage = &image;
+	mNextTile = 0;
+	mNumBusyWorkers = (int32_t)mWorkers.size();
+	for (auto& worker : mWorkers)
+		worker->notify();
+	
+	this->RasterizeTiles();
+	if (!mWorkers.empty())
+		mWorkersDone.wait(-1);
+	mImage = nullptr;
+	
+	const int64 done = Time::getHighResolutionTicks();
+	mRecordMS = Time::highResolutionTicksToSeconds(recorded - start) * 1000.0;
+	mRasterMS = Time::highResolutionTicksToSeconds(done - recorded) * 1000.0;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Bin
+//   - each draw goes in the bin of every tile its bounds overlap (they're
+//     already within the image, since the recording started clipped to it)
+/*---------------------------------------------------------------------------*/
+void TileRenderer::Bin(const Rectangle<int>& bounds)
+{
+	const int32_t numCols = (bounds.getWidth() + kTileSize - 1) / kTileSize;
+	const int32_t numRows = (bounds.getHeight() + kTileSize - 1) / kTileSize;
+	if (mTiles.empty() || mTiles.front().getPosition() != bounds.getPosition() || mTiles.size() != (size_t)(numCols * numRows) || mTiles.back().getBottomRight() != bounds.getBottomRight())
+	{
+		mTiles.clear();
+		for (int32_t row = 0; row < numRows; row++)
+			for (int32_t col = 0; col < numCols; col++)
+				mTiles.push_back(Rectangle<int>(bounds.getX() + col * kTileSize, bounds.getY() + row * kTileSize, kTileSize, kTileSize).getIntersection(bounds));
+		
+		mBins.resize(mTiles.size());
+	}
+	
+	for (std::vector<int32_t>& bin : mBins)
+		bin.clear();
+	
+	for (int32_t k = 0; k < mDrawList.GetNumOps(); k++)
+	{
+		if (!mDrawList.IsDraw(k))
+			continue;
+		
+		const Rectangle<int>& r = mDrawList.GetBounds(k);
+		const int32_t col0 = (r.getX() - bounds.getX()) / kTileSize;
+		const int32_t col1 = (r.getRight() - 1 - bounds.getX()) / kTileSize;
+		const int32_t row0 = (r.getY() - bounds.getY()) / kTileSize;
+		const int32_t row1 = (r.getBottom() - 1 - bounds.getY()) / kTileSize;
+		for (int32_t row = row0; row <= row1; row++)
+			for (int32_t col = col0; col <= col1; col++)
+				mBins[row * numCols + col].push_back(k);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RasterizeTiles
+//   - until they've all been taken (by this thread or the others)
+/*---------------------------------------------------------------------------*/
+void TileRenderer::RasterizeTiles()
+{
+	for (int32_t tile = mNextTile++; tile < (int32_t)mTiles.size(); tile = mNextTile++)
+		this->RasterizeTile(tile);
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RasterizeTile
+//   - plays back every state change, and the draws in this tile's bin, in
+//     order - up to the last draw (nothing after it touches this tile)
+/*---------------------------------------------------------------------------*/
+void TileRenderer::RasterizeTile(int32_t tile)
+{
+	const std::vector<int32_t>& bin = mBins[tile];
+	if (bin.empty())
+		return;
+	
+	StTraceScope trace("tile");
+	LowLevelGraphicsSoftwareRenderer c(*mImage, {0, 0}, RectangleList<int>(mTiles[tile]));
+	
+	size_t next = 0;
+	for (int32_t k = 0; k <= bin.back(); k++)
+	{
+		if (!mDrawList.IsDraw(k))
+			mDrawList.Replay(k, c);
+		else if (k == bin[next])
+		{
+			mDrawList.Replay(k, c);
+			next++;
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	ReplayUntiled
+//   - the whole recording in one pass on this thread, no tiles or bins
+/*---------------------------------------------------------------------------*/
+void TileRenderer::ReplayUntiled(Image& image) const
+{
+	LowLevelGraphicsSoftwareRenderer c(image, {0, 0}, RectangleList<int>(image.getBounds()));
+	for (int32_t k = 0; k < mDrawList.GetNumOps(); k++)
+		mDrawList.Replay(k, c);
+}
+
+/*---------------------------------------------------------------------------*/
+int64_t CountDifferentPixels(const Image& a, const Image& b)
+{
+	const Image::BitmapData da(a, Image::BitmapData::readOnly);
+	const Image::BitmapData db(b, Image::BitmapData::readOnly);
+	
+	int64_t count = 0;
+	for (int32_t y = 0; y < a.getHeight(); y++)
+		for (int32_t x = 0; x < a.getWidth(); x++)
+			if (da.getPixelColour(x, y) != db.getPixelColour(x, y))
+				count++;
+	
+	return count;
+}
@@ -0,0 +1,196 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	TileRenderer.h
+	
+	An optional way to rasterize a frame on more than one core. JUCE's
+	software renderer draws a frame on whichever thread calls it, so here
+	the frame is drawn into a DrawList instead - a LowLevelGraphicsContext
+	that just records each call, with the area it can touch - and the
+	recording is then played back into the frame's Image once per tile,
+	with the tiles shared out between worker threads.
+	
+	Each tile's playback is clipped to the tile and only includes the draws
+	that overlap it (the state changes all go to every tile), and JUCE's
+	rasterizer works out every pixel the same whatever the clip, so the
+	frame comes out exactly as if it had been drawn directly (the
+	render/tiles benchmarks and --headless --check-tiles fail if it doesn't).
+	The tiles don't overlap, so the workers never write the same pixel.
+	
+	This lives in the global namespace (like IPongView) so MainComponent,
+	which has its own 'pong', can use it.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// DrawList - records a frame's graphics calls, for playing back later
+class DrawList : public LowLevelGraphicsContext
+{
+public:
+	// a new frame, drawing into an image with these bounds
+	void	Reset(const Rectangle<int>& bounds);
+	
+	int32_t	GetNumOps() const { return (int32_t)mOps.size(); }
+	int32_t	GetNumDraws() const { return mNumDraws; }
+	
+	// the pixels op k can touch (conservatively), or empty if it only changes the state
+	const Rectangle<int>& GetBounds(int32_t k) const { return mOps[k].mBounds; }
+	bool	IsDraw(int32_t k) const { return mOps[k].mType >= eFirstDraw; }
+	
+	void	Replay(int32_t k, LowLevelGraphicsContext& c) const;
+	
+	// LowLevelGraphicsContext
+	bool	isVectorDevice() const override { return false; }
+	void	setOrigin(Point<int> o) override;
+	void	addTransform(const AffineTransform& t) override;
+	float	getPhysicalPixelScaleFactor() override;
+	bool	clipToRectangle(const Rectangle<int>& r) override;
+	bool	clipToRectangleList(const RectangleList<int>& r) override;
+	void	excludeClipRectangle(const Rectangle<int>& r) override;
+	void	clipToPath(const Path& p, const AffineTransform& t) override;
+	void	clipToImageAlpha(const Image& img, const AffineTransform& t) override;
+	bool	clipRegionIntersects(const Rectangle<int>& r) override;
+	Rectangle<int> getClipBounds() const override;
+	bool	isClipEmpty() const override { return mState.mClip.isEmpty(); }
+	void	saveState() override;
+	void	restoreState() override;
+	void	beginTransparencyLayer(float opacity) override;
+	void	endTransparencyLayer() override;
+	void	setFill(const FillType& fill) override;
+	void	setOpacity(float opacity) override;
+	void	setInterpolationQuality(Graphics::ResamplingQuality quality) override;
+	void	fillRect(const Rectangle<int>& r, bool replaceExistingContents) override;
+	void	fillRect(const Rectangle<float>& r) override;
+	void	fillRectList(const RectangleList<float>& r) override;
+	void	fillPath(const Path& p, const AffineTransform& t) override;
+	void	drawImage(const Image& img, const AffineTransform& t) override;
+	void	drawLine(const Line<float>& line) override;
+	void	setFont(const Font& font) override;
+	const Font& getFont() override { return mState.mFont; }
+	void	drawGlyph(int glyphNumber, const AffineTransform& t) override;
+
+private:
+	enum OpType
+	{
+		// state
+		eSetOrigin,
+		eAddTransform,
+		eClipToRectangle,
+		eClipToRectangleList,
+		eExcludeClipRectangle,
+		eClipToPath,
+		eClipToImageAlpha,
+		eSaveState,
+		eRestoreState,
+		eSetFill,
+		eSetOpacity,
+		eSetInterpolationQuality,
+		eSetFont,
+		
+		// draws
+		eFirstDraw,
+		eBeginTransparencyLayer = eFirstDraw,
+		eEndTransparencyLayer,
+		eFillRectInt,
+		eFillRect,
+		eFillRectList,
+		eFillPath,
+		eDrawImage,
+		eDrawLine,
+		eDrawGlyph
+	};
+	
+	struct Op
+	{
+		OpType			mType;
+		Rectangle<int>	mBounds;
+		Rectangle<float> mRect;
+		Line<float>		mLine;
+		AffineTransform	mTransform;
+		int32_t			mValue;		// glyph, quality, replace, or an index into a vector below
+		float			mOpacity;
+	};
+	
+	// what the recording needs to know about the state, for the bounds
+	struct State
+	{
+		AffineTransform	mTransform;	// user to device
+		Rectangle<int>	mClip;		// device, a bounding box of the real clip
+		Font			mFont;
+	};
+	
+	Op&		Add(OpType type, const Rectangle<int>& bounds = {});
+	
+	// r (drawn through t) in device coordinates, within the clip
+	Rectangle<int> DeviceBounds(const Rectangle<float>& r, const AffineTransform& t = {}) const;
+	
+	std::vector<Op>		mOps;
+	int32_t				mNumDraws = 0;
+	Rectangle<int>		mFrameBounds;
+	State				mState;
+	std::vector<State>	mSavedStates;
+	
+	// the bigger arguments
+	std::vector<Path>	mPaths;
+	std::vector<Image>	mImages;
+	std::vector<FillType> mFills;
+	std::vector<Font>	mFonts;
+	std::vector<RectangleList<int>> mClipLists;
+	std::vector<RectangleList<float>> mRectLists;
+};
+
+// TileRenderer
+class TileRenderer
+{
+public:
+	static const int32_t kTileSize = 128;
+	
+	// numThreads includes the calling thread - 1 rasterizes the tiles on it alone
+	TileRenderer(int32_t numThreads);
+	~TileRenderer();
+	
+	// calls draw() once to record the frame, then rasterizes it into image
+	void	Render(Image& image, const std::function<void(Graphics&)>& draw);
+	
+	int32_t	GetNumThreads() const { return (int32_t)mWorkers.size() + 1; }
+	const DrawList& GetDrawList() const { return mDrawList; }
+	
+	// plays the last recording into image in one pass, untiled - what drawing
+	// it directly would have produced, for checking the tiles (--check-tiles)
+	void	ReplayUntiled(Image& image) const;
+	
+	// the last Render
+	double	GetRecordMS() const { return mRecordMS; }
+	double	GetRasterMS() const { return mRasterMS; }
+
+private:
+	class Worker;
+	
+	void	Bin(const Rectangle<int>& bounds);
+	void	RasterizeTiles();
+	void	RasterizeTile(int32_t tile);
+	
+	DrawList			mDrawList;
+	std::vector<Rectangle<int>> mTiles;
+	std::vector<std::vector<int32_t>> mBins; // each tile's draws, in order
+	
+	// while rasterizing
+	Image*				mImage = nullptr;
+	std::atomic<int32_t> mNextTile;
+	std::atomic<int32_t> mNumBusyWorkers;
+	WaitableEvent		mWorkersDone;
+	
+	std::vector<std::unique_ptr<Worker>> mWorkers;
+	
+	double				mRecordMS = 0;
+	double				mRasterMS = 0;
+};
+
+// the number of pixels that differ between two images the same size
+int64_t CountDifferentPixels(const Image& a, const Image& b);
@@ -0,0 +1,128 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	Trace.cpp
+*****************************************************************************/
+
+#include "Trace.h"
+#include <algorithm>
+#include <sstream>
+
+TraceRecorder gTraceRecorder;
+
+namespace
+{
+	thread_local TraceBuffer* tThreadBuffer = nullptr;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	Snapshot
+//   - the writer never waits for us, so read the index, copy, and then throw
+//     away anything the writer may have lapped while we were copying - that
+//     includes the slot it could be halfway through writing (endAfter), which
+//     it hasn't published yet
+/*---------------------------------------------------------------------------*/
+void TraceBuffer::Snapshot(std::vector<TraceEvent>& events) const
+{
+	const uint32_t end = mWriteIndex.load(std::memory_order_acquire);
+	const uint32_t count = std::min(end, kNumEvents);
+	const uint32_t begin = (end - count);
+	
+	std::vector<TraceEvent> copy(count);
+	for (uint32_t k = 0; k < count; k++)
+		copy[k] = mEvents[(begin + k) & (kNumEvents - 1)];
+	
+	const uint32_t endAfter = mWriteIndex.load(std::memory_order_acquire);
+	const uint32_t reach = (endAfter - begin) + 1; // slots from begin through endAfter
+	const uint32_t lapped = (reach > kNumEvents) ? std::min(count, reach - kNumEvents) : 0;
+	
+	events.insert(events.end(), copy.begin() + lapped, copy.end());
+}
+
+/*---------------------------------------------------------------------------*/
+TraceBuffer& TraceRecorder::GetThreadBuffer()
+{
+	if (!tThreadBuffer)
+		tThreadBuffer = &this->RegisterThread();
+	return *tThreadBuffer;
+}
+
+/*---------------------------------------------------------------------------*/
+TraceBuffer* TraceRecorder::ReserveThreadBuffer(const char* name)
+{
+	TraceBuffer* buffer = &this->RegisterThread();
+	buffer->mThreadName.store(name, std::memory_order_relaxed);
+	return buffer;
+}
+
+/*---------------------------------------------------------------------------*/
+void TraceRecorder::UseThreadBuffer(TraceBuffer* buffer)
+{
+	tThreadBuffer = buffer;
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	RegisterThread
+//   - the only allocation & lock a recording thread ever sees
+/*---------------------------------------------------------------------------*/
+TraceBuffer& TraceRecorder::RegisterThread()
+{
+	const ScopedLock lock(mLock);
+	mBuffers.emplace_back(new TraceBuffer(++mNumThreads));
+	return *mBuffers.back();
+}
+
+/*---------------------------------------------------------------------------*/
+// 	METHOD:	WriteJSON
+//   - Chrome trace_event format - complete ('X') events plus thread names,
+//     with times in microseconds from the start of the capture
+/*---------------------------------------------------------------------------*/
+bool TraceRecorder::WriteJSON(const File& file, double seconds)
+{
+	const int64_t nowTicks = Time::getHighResolutionTicks();
+	const int64_t fromTicks = nowTicks - Time::secondsToHighResolutionTicks(seconds);
+	auto toMicros = [fromTicks](int64_t ticks) { return Time::highResolutionTicksToSeconds(ticks - fromTicks) * 1.0e6; };
+	
+	std::stringstream json;
+	json.precision(3);
+	json << std::fixed << "{\"traceEvents\":[\n";
+	
+	bool first = true;
+	auto separator = [&first]() { const char* s = (first ? "" : ",\n"); first = false; return s; };
+	
+	int32_t numEvents = 0;
+	{
+		const ScopedLock lock(mLock);
+		for (const auto& buffer : mBuffers)
+		{
+			const char* name = buffer->mThreadName.load(std::memory_order_relaxed);
+			const String threadName = (name ? String(name) : "thread " + String(buffer->mThreadID));
+			json << separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->mThreadID
+				 << ",\"args\":{\"name\":\"" << threadName.toStdString() << "\"}}";
+			
+			std::vector<TraceEvent> events;
+			buffer->Snapshot(events);
+			
+			for (const TraceEvent& e : events)
+			{
+				if (e.mStartTicks + e.mDurationTicks < fromTicks)
+					continue;
+				
+				json << separator() << "{\"name\":\"" << e.mName << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->mThreadID
+					 << ",\"ts\":" << toMicros(e.mStartTicks)
+					 << ",\"dur\":" << Time::highResolutionTicksToSeconds(e.mDurationTicks) * 1.0e6 << "}";
+				numEvents++;
+			}
+		}
+	}
+	
+	json << "\n]}\n";
+	
+	file.deleteFile();
+	if (!file.replaceWithText(json.str()))
+		return false;
+	
+	printf("trace: %d events from the last %.0f sec written to %s\n", numEvents, seconds, file.getFullPathName().toRawUTF8());
+	return true;
+}
@@ -0,0 +1,114 @@
+// copyright (c) 1990-2017 by Digidesign, Inc. All rights reserved.
+
+/*****************************************************************************
+
+	Trace.h
+	
+	Timeline tracing. Every thread that records gets its own fixed size ring
+	of events (registered the first time it records), so the message thread,
+	the audio thread and any workers never contend - a scope is two tick
+	reads and a store. 'C' in the game (or WriteJSON) dumps the last few
+	seconds as Chrome trace_event JSON, which opens in Perfetto or
+	chrome://tracing.
+	
+	This lives in the global namespace (like IPongView) so MainComponent,
+	which has its own 'pong', can use it.
+*****************************************************************************/
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// TraceEvent - one completed scope
+struct TraceEvent
+{
+	const char*	mName; // must be a string literal
+	int64_t		mStartTicks;
+	int64_t		mDurationTicks;
+};
+
+// TraceBuffer - single writer ring of events, owned by one thread
+class TraceBuffer
+{
+public:
+	static const uint32_t kNumEvents = (1 << 14); // power of 2
+	
+	TraceBuffer(int32_t threadID) : mThreadID(threadID), mThreadName(nullptr), mWriteIndex(0) {}
+	
+	void Add(const char* name, int64_t startTicks, int64_t durationTicks)
+	{
+		const uint32_t index = mWriteIndex.load(std::memory_order_relaxed);
+		mEvents[index & (kNumEvents - 1)] = {name, startTicks, durationTicks};
+		mWriteIndex.store(index + 1, std::memory_order_release);
+	}
+	
+	// copies out the events the writer hasn't overwritten while we were reading
+	void Snapshot(std::vector<TraceEvent>& events) const;
+	
+	const int32_t		mThreadID;
+	std::atomic<const char*> mThreadName;
+
+private:
+	std::atomic<uint32_t> mWriteIndex;
+	TraceEvent			mEvents[kNumEvents];
+};
+
+// TraceRecorder
+class TraceRecorder
+{
+public:
+	TraceRecorder() : mEnabled(false), mNumThreads(0) {}
+	
+	bool	IsEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+	void	SetEnabled(bool enabled) { mEnabled.store(enabled, std::memory_order_relaxed); }
+	
+	// the name shown for the calling thread (must be a string literal)
+	void	SetThreadName(const char* name) { this->GetThreadBuffer().mThreadName.store(name, std::memory_order_relaxed); }
+	
+	// for a thread that mustn't allocate or lock (the audio thread) - the
+	// buffer's registered ahead of time on another thread, and then the
+	// thread itself just starts recording into it
+	TraceBuffer* ReserveThreadBuffer(const char* name);
+	void	UseThreadBuffer(TraceBuffer* buffer);
+	
+	void	Add(const char* name, int64_t startTicks, int64_t durationTicks)
+	{
+		this->GetThreadBuffer().Add(name, startTicks, durationTicks);
+	}
+	
+	// everything that ended in the last 'seconds', from every thread
+	bool	WriteJSON(const File& file, double seconds);
+
+private:
+	TraceBuffer& GetThreadBuffer();
+	TraceBuffer& RegisterThread();
+	
+	std::atomic<bool>	mEnabled;
+	int32_t				mNumThreads;
+	CriticalSection		mLock; // guards mBuffers - taken once per thread, and when writing
+	std::vector<std::unique_ptr<TraceBuffer>> mBuffers;
+};
+
+extern TraceRecorder gTraceRecorder;
+
+/*---------------------------------------------------------------------------*/
+// StTraceScope - records the enclosing scope (when tracing is enabled)
+class StTraceScope
+{
+public:
+	StTraceScope(const char* name) :
+		mName(name),
+		mStartTicks(gTraceRecorder.IsEnabled() ? Time::getHighResolutionTicks() : 0)
+	{}
+	~StTraceScope()
+	{
+		if (mStartTicks)
+			gTraceRecorder.Add(mName, mStartTicks, Time::getHighResolutionTicks() - mStartTicks);
+	}
+
+private:
+	const char*		mName;
+	const int64_t	mStartTicks;
+};